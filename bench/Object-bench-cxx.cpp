@@ -0,0 +1,133 @@
+/* C++ counterparts of the SCOOP Object benchmark classes, using
+ * virtual functions, virtual destructors and dynamic_cast
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Object-bench.h"
+#include <new>
+
+/*
+ * Level N of the hierarchy. C++ has no static virtual functions, so g()
+ * is an ordinary virtual function which does not use the object.
+ */
+
+template<int N> struct D : D<N - 1> {
+	int v;
+	D() { v = N; }
+	virtual ~D() { bench_sink += v; }
+	virtual int f(int x) { return x + v; }
+	virtual int g(int x) { return x + N; }
+};
+
+template<> struct D<0> {
+	int v;
+	D() { v = 0; }
+	virtual ~D() { bench_sink += v; }
+	virtual int f(int x) { return x + v; }
+	virtual int g(int x) { return x; }
+};
+
+/* padded to Size bytes like the SCOOP size classes */
+template<size_t Size> struct S : D<0> {
+	char pad[Size - sizeof(void*) - sizeof(int)];
+};
+
+typedef D<0> Base;
+
+template<class T> static void make_n(void **objs, size_t n, char *mem)
+{
+	const size_t stride = (sizeof(T) + 15) & ~(size_t)15;
+	for (size_t i = 0; i < n; ++i)
+		objs[i] = static_cast<Base*>(mem ?
+				new (mem + i * stride) T() : new T());
+}
+
+struct cls {
+	size_t size;
+	void (*make_n)(void **objs, size_t n, char *mem);
+};
+
+#define CLS(T) {sizeof(T), make_n<T>}
+static const cls classes[CLASSES] = {
+	CLS(D<0>), CLS(D<1>), CLS(D<2>), CLS(D<3>), CLS(D<4>), CLS(D<5>),
+	CLS(D<6>), CLS(D<7>), CLS(D<8>), CLS(D<9>), CLS(D<10>), CLS(D<11>),
+	CLS(D<12>), CLS(D<13>), CLS(D<14>), CLS(D<15>), CLS(D<16>),
+	CLS(S<16>), CLS(S<64>), CLS(S<256>), CLS(S<1024>),
+};
+
+static size_t cxx_size(int c)
+{
+	return classes[c].size;
+}
+
+static void cxx_make_n(int c, void **objs, size_t n, char *mem)
+{
+	classes[c].make_n(objs, n, mem);
+}
+
+static void cxx_delete_n(void **objs, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		delete static_cast<Base*>(objs[i]);
+}
+
+static void cxx_finalize_n(void **objs, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		static_cast<Base*>(objs[i])->~Base();
+}
+
+static long cxx_virt_n(void **objs, size_t n)
+{
+	long sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += static_cast<Base*>(objs[i])->f(1);
+	return sum;
+}
+
+static long cxx_svirt_n(void **objs, size_t n)
+{
+	long sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += static_cast<Base*>(objs[i])->g(1);
+	return sum;
+}
+
+static long cxx_rtti_n(void **objs, size_t n)
+{
+	long sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += dynamic_cast<D<1>*>(static_cast<Base*>(objs[i])) != 0;
+	return sum;
+}
+
+extern "C" const bench_impl bench_cxx = {
+	"c++",
+	cxx_size,
+	cxx_make_n,
+	cxx_delete_n,
+	cxx_delete_n, /* no bulk delete */
+	cxx_finalize_n,
+	cxx_virt_n,
+	cxx_svirt_n,
+	cxx_rtti_n,
+};
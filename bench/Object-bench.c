@@ -0,0 +1,414 @@
+/* Benchmark for the core operations of the SCOOP Object module,
+ * compared with equivalent C++ classes, printing results as JSON
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Object-bench.h"
+#include <scoop/Object.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define OBJECTS 10000 /* per thread, for allocation and destruction */
+#define ROUNDS 20
+#define CALLS 2000000 /* per thread, over the first WORKSET objects */
+#define WORKSET 1024
+#define TRIALS 3 /* the best of which is kept */
+
+__thread long bench_sink;
+
+/*
+ * The hierarchy, D0 - D16, and the size classes S16 - S1024.
+ */
+
+#define D0_ int v0;
+#define D0__ int (*f)(void *o, int x); int (*g)(int x);
+#define D1_ D0_ int v1;
+#define D2_ D1_ int v2;
+#define D3_ D2_ int v3;
+#define D4_ D3_ int v4;
+#define D5_ D4_ int v5;
+#define D6_ D5_ int v6;
+#define D7_ D6_ int v7;
+#define D8_ D7_ int v8;
+#define D9_ D8_ int v9;
+#define D10_ D9_ int v10;
+#define D11_ D10_ int v11;
+#define D12_ D11_ int v12;
+#define D13_ D12_ int v13;
+#define D14_ D13_ int v14;
+#define D15_ D14_ int v15;
+#define D16_ D15_ int v16;
+#define S_PAD(size) char pad[size - sizeof(void*) - sizeof(int)];
+#define S16_ D0_ S_PAD(16)
+#define S64_ D0_ S_PAD(64)
+#define S256_ D0_ S_PAD(256)
+#define S1024_ D0_ S_PAD(1024)
+
+/* defines the meta type and constructor of a class, the body of which
+ * follows, and a function constructing instances in a loop */
+#define CLASSDEF(Class, Superclass, dtor, vtinit) \
+_SCOmetainst(Class, Superclass, dtor, vtinit); \
+static Class *Class##_new(Class *o); \
+static void Class##_make_n(void **objs, size_t n, char *mem) \
+{ \
+	const size_t stride = (sizeof(Class) + 15) & ~(size_t)15; \
+	size_t i; \
+	for (i = 0; i < n; ++i) \
+		objs[i] = Class##_new(mem ? (Class*)(mem + i * stride) : 0); \
+} \
+_SCOctordef(Class, Class,, (Class *o), (o))
+
+#define D_FUNCS(Class, n) \
+static void Class##_dtor(Class *o) { bench_sink += o->v##n; } \
+static int Class##_f(void *o, int x) { return x + ((Class*)o)->v##n; } \
+static int Class##_g(int x) { return x + n; } \
+static void Class##_vtinit(Class##_Meta *o) \
+{ \
+	o->virt.f = Class##_f; \
+	o->virt.g = Class##_g; \
+}
+
+_SCOclassdef(D0);
+D_FUNCS(D0, 0)
+CLASSDEF(D0, scoNone, D0_dtor, D0_vtinit)
+{
+	o->v0 = 0;
+	return 1;
+}
+
+#define LEVELDEF(n, p) \
+_SCOclassdef(D##n); \
+D_FUNCS(D##n, n) \
+CLASSDEF(D##n, D##p, D##n##_dtor, D##n##_vtinit) \
+{ \
+	D##p##_ctor((D##p*)o); \
+	o->v##n = n; \
+	return 1; \
+}
+
+#define D1__ D0__
+LEVELDEF(1, 0)
+#define D2__ D1__
+LEVELDEF(2, 1)
+#define D3__ D2__
+LEVELDEF(3, 2)
+#define D4__ D3__
+LEVELDEF(4, 3)
+#define D5__ D4__
+LEVELDEF(5, 4)
+#define D6__ D5__
+LEVELDEF(6, 5)
+#define D7__ D6__
+LEVELDEF(7, 6)
+#define D8__ D7__
+LEVELDEF(8, 7)
+#define D9__ D8__
+LEVELDEF(9, 8)
+#define D10__ D9__
+LEVELDEF(10, 9)
+#define D11__ D10__
+LEVELDEF(11, 10)
+#define D12__ D11__
+LEVELDEF(12, 11)
+#define D13__ D12__
+LEVELDEF(13, 12)
+#define D14__ D13__
+LEVELDEF(14, 13)
+#define D15__ D14__
+LEVELDEF(15, 14)
+#define D16__ D15__
+LEVELDEF(16, 15)
+
+#define SIZEDEF(size) \
+_SCOclassdef(S##size); \
+CLASSDEF(S##size, D0, 0, 0) \
+{ \
+	D0_ctor((D0*)o); \
+	return 1; \
+}
+
+#define S16__ D0__
+SIZEDEF(16)
+#define S64__ D0__
+SIZEDEF(64)
+#define S256__ D0__
+SIZEDEF(256)
+#define S1024__ D0__
+SIZEDEF(1024)
+
+/*
+ * The SCOOP implementation of the operations.
+ */
+
+static const struct {
+	size_t size;
+	void (*make_n)(void **objs, size_t n, char *mem);
+} classes[CLASSES] = {
+#define CLS(Class) {sizeof(Class), Class##_make_n}
+	CLS(D0), CLS(D1), CLS(D2), CLS(D3), CLS(D4), CLS(D5),
+	CLS(D6), CLS(D7), CLS(D8), CLS(D9), CLS(D10), CLS(D11),
+	CLS(D12), CLS(D13), CLS(D14), CLS(D15), CLS(D16),
+	CLS(S16), CLS(S64), CLS(S256), CLS(S1024),
+#undef CLS
+};
+
+static size_t sco_size(int cls)
+{
+	return classes[cls].size;
+}
+
+static void sco_make_n(int cls, void **objs, size_t n, char *mem)
+{
+	classes[cls].make_n(objs, n, mem);
+}
+
+static void sco_delete_each(void **objs, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		sco_delete(objs[i]);
+}
+
+static void sco_delete_bulk(void **objs, size_t n)
+{
+	sco_delete_n(objs, n);
+}
+
+static void sco_finalize_n(void **objs, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		sco_finalize(objs[i]);
+}
+
+static long sco_virt_n(void **objs, size_t n)
+{
+	long sum = 0;
+	size_t i;
+	for (i = 0; i < n; ++i) {
+		D0 *o = objs[i];
+		sum += sco_virt(f, o, 1);
+	}
+	return sum;
+}
+
+static long sco_svirt_n(void **objs, size_t n)
+{
+	long sum = 0;
+	size_t i;
+	for (i = 0; i < n; ++i) {
+		D0 *o = objs[i];
+		sum += sco_svirt(g, o, 1);
+	}
+	return sum;
+}
+
+static long sco_rtti_n(void **objs, size_t n)
+{
+	long sum = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+		sum += sco_of_class(objs[i], D1);
+	return sum;
+}
+
+static const struct bench_impl bench_scoop = {
+	"scoop",
+	sco_size,
+	sco_make_n,
+	sco_delete_each,
+	sco_delete_bulk,
+	sco_finalize_n,
+	sco_virt_n,
+	sco_svirt_n,
+	sco_rtti_n,
+};
+
+/*
+ * Measurement.
+ */
+
+enum {
+	OP_NEW,
+	OP_DELETE,
+	OP_DELETE_N,
+	OP_FINALIZE,
+	OP_VIRT,
+	OP_SVIRT,
+	OP_RTTICHECK,
+	OPS
+};
+
+static const char *const op_names[OPS] = {
+	"new", "delete", "delete_n", "finalize", "virt", "svirt", "rtticheck"
+};
+
+struct job {
+	const struct bench_impl *impl;
+	int cls;
+	pthread_barrier_t *barrier;
+	double ns[OPS]; /* total for each operation */
+	long sum;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *worker(void *arg)
+{
+	struct job *job = arg;
+	const struct bench_impl *impl = job->impl;
+	size_t stride = (impl->size(job->cls) + 15) & ~(size_t)15;
+	void **objs = malloc(OBJECTS * sizeof(void*));
+	char *mem = malloc(OBJECTS * stride);
+	double t;
+	int i;
+	if (!objs || !mem) {
+		fputs("out of memory\n", stderr);
+		exit(1);
+	}
+	pthread_barrier_wait(job->barrier);
+	for (i = 0; i < ROUNDS; ++i) {
+		t = now();
+		impl->make_n(job->cls, objs, OBJECTS, 0);
+		job->ns[OP_NEW] += now() - t;
+		t = now();
+		impl->delete_n(objs, OBJECTS);
+		job->ns[OP_DELETE] += now() - t;
+		impl->make_n(job->cls, objs, OBJECTS, 0);
+		t = now();
+		impl->delete_bulk(objs, OBJECTS);
+		job->ns[OP_DELETE_N] += now() - t;
+		impl->make_n(job->cls, objs, OBJECTS, mem);
+		t = now();
+		impl->finalize_n(objs, OBJECTS);
+		job->ns[OP_FINALIZE] += now() - t;
+	}
+	impl->make_n(job->cls, objs, WORKSET, 0);
+	t = now();
+	for (i = 0; i < CALLS / WORKSET; ++i)
+		job->sum += impl->virt_n(objs, WORKSET);
+	job->ns[OP_VIRT] += now() - t;
+	t = now();
+	for (i = 0; i < CALLS / WORKSET; ++i)
+		job->sum += impl->svirt_n(objs, WORKSET);
+	job->ns[OP_SVIRT] += now() - t;
+	t = now();
+	for (i = 0; i < CALLS / WORKSET; ++i)
+		job->sum += impl->rtti_n(objs, WORKSET);
+	job->ns[OP_RTTICHECK] += now() - t;
+	impl->delete_n(objs, WORKSET);
+	free(mem);
+	free(objs);
+	return 0;
+}
+
+/* runs one trial in \p threads threads, giving the average
+ * nanoseconds per operation for a thread in \p ns */
+static void trial(const struct bench_impl *impl, int cls, int threads,
+		double *ns)
+{
+	static const double count[OPS] = {
+		OBJECTS * ROUNDS, OBJECTS * ROUNDS, OBJECTS * ROUNDS,
+		OBJECTS * ROUNDS,
+		CALLS / WORKSET * WORKSET, CALLS / WORKSET * WORKSET,
+		CALLS / WORKSET * WORKSET
+	};
+	pthread_t thread[threads];
+	struct job job[threads];
+	pthread_barrier_t barrier;
+	int i, op;
+	pthread_barrier_init(&barrier, 0, threads);
+	for (i = 0; i < threads; ++i) {
+		job[i] = (struct job){impl, cls, &barrier, {0}, 0};
+		pthread_create(&thread[i], 0, worker, &job[i]);
+	}
+	for (op = 0; op < OPS; ++op)
+		ns[op] = 0;
+	for (i = 0; i < threads; ++i) {
+		pthread_join(thread[i], 0);
+		for (op = 0; op < OPS; ++op)
+			ns[op] += job[i].ns[op] / count[op] / threads;
+	}
+	pthread_barrier_destroy(&barrier);
+}
+
+static void measure(const struct bench_impl *impl, int cls, int threads)
+{
+	static int first = 1;
+	double best[OPS], ns[OPS];
+	int i, op;
+	for (i = 0; i < TRIALS; ++i) {
+		trial(impl, cls, threads, ns);
+		for (op = 0; op < OPS; ++op)
+			if (i == 0 || ns[op] < best[op]) best[op] = ns[op];
+	}
+	for (op = 0; op < OPS; ++op) {
+		printf("%s\n    {\"impl\": \"%s\", \"op\": \"%s\", "
+				"\"depth\": %d, \"size\": %zu, "
+				"\"threads\": %d, \"ns_per_op\": %.3f}",
+				first ? "" : ",",
+				impl->name, op_names[op],
+				cls <= DEPTH_MAX ? cls : 1,
+				impl->size(cls), threads, best[op]);
+		first = 0;
+	}
+}
+
+/*
+ * Prints a JSON object with the parameters and a list of results,
+ * each giving the time per operation (averaged over threads, and the
+ * best of a few trials) for an implementation and a class.
+ *
+ * The sweeps are over the depth of the class in the hierarchy with one
+ * thread, over object sizes with one thread, and over thread counts for
+ * a class of depth 4.
+ */
+int main()
+{
+	static const int depths[] = {0, 1, 2, 4, 8, 16};
+	static const int thread_counts[] = {1, 2, 4, 8};
+	const struct bench_impl *const impls[] = {&bench_scoop, &bench_cxx};
+	size_t i, j;
+	printf("{\n  \"benchmark\": \"Object-bench\",\n"
+			"  \"objects\": %d,\n  \"rounds\": %d,\n"
+			"  \"calls\": %d,\n  \"trials\": %d,\n"
+			"  \"results\": [",
+			OBJECTS, ROUNDS, CALLS / WORKSET * WORKSET, TRIALS);
+	for (i = 0; i < sizeof(impls) / sizeof(*impls); ++i) {
+		for (j = 0; j < sizeof(depths) / sizeof(*depths); ++j)
+			measure(impls[i], depths[j], 1);
+		for (j = 0; j < SIZES; ++j)
+			measure(impls[i], DEPTH_MAX + 1 + j, 1);
+		for (j = 0; j < sizeof(thread_counts) /
+				sizeof(*thread_counts); ++j)
+			measure(impls[i], 4, thread_counts[j]);
+	}
+	printf("\n  ]\n}\n");
+	return 0;
+}
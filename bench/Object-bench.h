@@ -0,0 +1,75 @@
+/* Common definitions for the SCOOP Object benchmark, shared between
+ * the SCOOP classes and their C++ counterparts
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef bench_Object_bench_h
+#define bench_Object_bench_h
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each implementation has the same classes, numbered as follows:
+ *
+ * - 0 to DEPTH_MAX: a hierarchy of levels, each with a constructor and
+ *   destructor and overriding the two virtual functions, f() taking the
+ *   object and g() not taking it (a static virtual function).
+ * - DEPTH_MAX + 1 and on: one class for each of the SIZES object sizes
+ *   16, 64, 256 and 1024 bytes, derived from level 0 and padded.
+ */
+
+#define DEPTH_MAX 16
+#define SIZES 4
+#define CLASSES (DEPTH_MAX + 1 + SIZES)
+
+/* written by destructors, so that they are not optimized away */
+extern __thread long bench_sink;
+
+/* the benchmarked operations of an implementation */
+struct bench_impl {
+	const char *name;
+	/* size of class \p cls */
+	size_t (*size)(int cls);
+	/* constructs \p n instances of class \p cls, allocating them
+	 * if \p mem is NULL, otherwise placing them in it one after
+	 * another at multiples of 16 bytes */
+	void (*make_n)(int cls, void **objs, size_t n, char *mem);
+	/* destroys and frees instances */
+	void (*delete_n)(void **objs, size_t n);
+	/* destroys and frees instances at once, if that is supported */
+	void (*delete_bulk)(void **objs, size_t n);
+	/* destroys instances without freeing them */
+	void (*finalize_n)(void **objs, size_t n);
+	/* call f(), g(), and check that each instance is of class 1 */
+	long (*virt_n)(void **objs, size_t n);
+	long (*svirt_n)(void **objs, size_t n);
+	long (*rtti_n)(void **objs, size_t n);
+};
+
+extern const struct bench_impl bench_cxx;
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,150 @@
+/* Benchmark for SCOOP actors, sending messages to a set of actors from
+ * several threads, run by pools of 1, 2 and 4 worker threads
+ * of objects of the test classes, and reporting the throughput in MB/s
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <scoop/Actor.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define ACTORS 64
+#define SENDERS 2
+#define MESSAGES 200000 /* per sender */
+#define WORK 200 /* loop iterations per message */
+#define REPEATS 3 /* the best of which is kept */
+
+/*
+ * An actor doing some work per message, and the same done by calling
+ * directly under a lock per object for comparison.
+ */
+
+#define Summer_ scoActor_ \
+	unsigned long sum; \
+	pthread_mutex_t lock;
+#define Summer__ scoActor__ \
+	void (*add)(void *o, void *arg);
+_SCOclassdef(Summer);
+
+static void Summer_add(void *_o, void *arg)
+{
+	Summer *o = _o;
+	unsigned long x = (unsigned long) arg, i;
+	for (i = 0; i < WORK; ++i)
+		x = x * 6364136223846793005UL + 1442695040888963407UL;
+	o->sum += x;
+}
+
+static void Summer_vtinit(Summer_Meta *o)
+{
+	o->virt.add = Summer_add;
+}
+_SCOmetainst(Summer, scoActor, 0, Summer_vtinit);
+
+static Summer *actors[ACTORS];
+static int use_lock;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *sender(void *arg)
+{
+	unsigned long i, n = (unsigned long) arg;
+	for (i = 0; i < MESSAGES; ++i) {
+		Summer *o = actors[(i * 7 + n) % ACTORS];
+		if (use_lock) {
+			pthread_mutex_lock(&o->lock);
+			Summer_add(o, (void*) i);
+			pthread_mutex_unlock(&o->lock);
+		} else {
+			sco_send(add, o, (void*) i);
+		}
+	}
+	return 0;
+}
+
+/* sends from SENDERS threads, run by \p workers, or called under locks
+ * if NULL, giving the messages per microsecond */
+static double run(scoWorkers *workers)
+{
+	pthread_t thread[SENDERS];
+	double t;
+	long i;
+	use_lock = !workers;
+	t = now();
+	for (i = 0; i < SENDERS; ++i)
+		pthread_create(&thread[i], 0, sender, (void*) i);
+	for (i = 0; i < SENDERS; ++i)
+		pthread_join(thread[i], 0);
+	if (workers)
+		sco_workers_wait(workers);
+	t = now() - t;
+	return (double) MESSAGES * SENDERS / t * 1e-6;
+}
+
+static void measure(unsigned int threads)
+{
+	scoWorkers *workers = threads ? sco_workers_create(threads) : 0;
+	double rate, best = 0;
+	int r, i;
+	if (threads && !workers)
+		return;
+	for (i = 0; i < ACTORS; ++i) {
+		actors[i] = sco_raw_new(0, sco_metaof(Summer));
+		sco_Actor_ctor((scoActor*)actors[i], workers);
+		pthread_mutex_init(&actors[i]->lock, 0);
+	}
+	for (r = 0; r < REPEATS; ++r) {
+		rate = run(workers);
+		if (rate > best) best = rate;
+	}
+	if (threads)
+		printf("actors, %u workers %14.2f messages/us\n",
+				threads, best);
+	else
+		printf("direct calls under mutex %8.2f messages/us\n", best);
+	if (workers)
+		sco_workers_destroy(workers);
+	for (i = 0; i < ACTORS; ++i) {
+		pthread_mutex_destroy(&actors[i]->lock);
+		sco_delete(actors[i]);
+	}
+}
+
+/*
+ * Times SENDERS threads sending messages round-robin to ACTORS actors,
+ * the pool running them with 1, 2 and 4 worker threads, against the
+ * sending threads making the calls themselves under a mutex per object.
+ */
+int main()
+{
+	static const unsigned int worker_counts[] = {1, 2, 4};
+	size_t i;
+	measure(0);
+	for (i = 0; i < sizeof(worker_counts) / sizeof(*worker_counts); ++i)
+		measure(worker_counts[i]);
+	return 0;
+}
@@ -0,0 +1,169 @@
+/* Benchmark for SCOOP batch virtual calls over arrays of objects of mixed
+ * classes, comparing them with a loop of sco_virt() calls
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Object.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define OBJECTS 50000
+#define REPEATS 200
+
+/*
+ * A base class with eight subclasses, S0 - S7, each defining its own
+ * update(); the first four also define update_all() for whole runs.
+ */
+
+#define Base_ long x;
+#define Base__ \
+	void (*update)(void *o); \
+	void (*update_all)(void *const *objs, size_t n);
+_SCOclassdef(Base);
+
+static void Base_update_all(void *const *objs, size_t n)
+{
+	Base *const *o = (Base *const *) objs;
+	size_t i;
+	for (i = 0; i < n; ++i)
+		sco_virt(update, o[i]);
+}
+
+static void Base_vtinit(Base_Meta *o)
+{
+	o->virt.update_all = Base_update_all;
+}
+_SCOmetainst(Base, scoNone, 0, Base_vtinit);
+
+#define SUBDEF(Class, expr, all) \
+_SCOclassdef(Class); \
+static void Class##_update(void *_o) \
+{ \
+	Base *o = _o; \
+	o->x = expr; \
+} \
+static void Class##_update_all(void *const *objs, size_t n) \
+{ \
+	Base *const *os = (Base *const *) objs; \
+	size_t i; \
+	for (i = 0; i < n; ++i) { \
+		Base *o = os[i]; \
+		o->x = expr; \
+	} \
+} \
+static void Class##_vtinit(Class##_Meta *o) \
+{ \
+	o->virt.update = Class##_update; \
+	if (all) o->virt.update_all = Class##_update_all; \
+} \
+_SCOmetainst(Class, Base, 0, Class##_vtinit)
+
+#define S0_ Base_
+#define S0__ Base__
+SUBDEF(S0, o->x + 1, 1);
+#define S1_ Base_
+#define S1__ Base__
+SUBDEF(S1, o->x ^ 2, 1);
+#define S2_ Base_
+#define S2__ Base__
+SUBDEF(S2, o->x * 3, 1);
+#define S3_ Base_
+#define S3__ Base__
+SUBDEF(S3, o->x - 4, 1);
+#define S4_ Base_
+#define S4__ Base__
+SUBDEF(S4, o->x + 5, 0);
+#define S5_ Base_
+#define S5__ Base__
+SUBDEF(S5, o->x ^ 6, 0);
+#define S6_ Base_
+#define S6__ Base__
+SUBDEF(S6, o->x * 7, 0);
+#define S7_ Base_
+#define S7__ Base__
+SUBDEF(S7, o->x - 8, 0);
+
+static void *const metas[] = {
+	sco_metaof(S0), sco_metaof(S1), sco_metaof(S2), sco_metaof(S3),
+	sco_metaof(S4), sco_metaof(S5), sco_metaof(S6), sco_metaof(S7),
+};
+
+static Base *objs[OBJECTS], *shuffled[OBJECTS];
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *what, double t)
+{
+	printf("%-32s %8.2f ns per object\n", what,
+			t * 1e9 / ((double) OBJECTS * REPEATS));
+}
+
+int main()
+{
+	unsigned int seed = 1;
+	size_t i;
+	int r;
+	double t;
+	for (i = 0; i < OBJECTS; ++i) {
+		seed = seed * 1103515245 + 12345;
+		shuffled[i] = sco_raw_new(0, metas[(seed >> 16) % 8]);
+	}
+	printf("%d objects of 8 interleaved classes, %d passes\n",
+			OBJECTS, REPEATS);
+
+	memcpy(objs, shuffled, sizeof(objs));
+	t = now();
+	for (r = 0; r < REPEATS; ++r)
+		for (i = 0; i < OBJECTS; ++i)
+			sco_virt(update, objs[i]);
+	report("sco_virt() loop", now() - t);
+
+	t = 0;
+	for (r = 0; r < REPEATS; ++r) {
+		double t0;
+		memcpy(objs, shuffled, sizeof(objs));
+		t0 = now();
+		sco_virt_batch(update, objs, OBJECTS);
+		t += now() - t0;
+	}
+	report("sco_virt_batch(), ungrouped", t);
+
+	t = now();
+	for (r = 0; r < REPEATS; ++r)
+		sco_virt_batch(update, objs, OBJECTS);
+	report("sco_virt_batch(), grouped", now() - t);
+
+	t = now();
+	for (r = 0; r < REPEATS; ++r)
+		sco_virt_bulk(update_all, objs, OBJECTS);
+	report("sco_virt_bulk(), grouped", now() - t);
+
+	for (i = 0; i < OBJECTS; ++i)
+		sco_delete(objs[i]);
+	return 0;
+}
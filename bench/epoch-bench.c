@@ -0,0 +1,177 @@
+/* Benchmark for the SCOOP Epoch module, comparing lock-free reads with
+ * epoch-based reclamation against reads under a mutex
+ * of objects of the test classes, and reporting the throughput in MB/s
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <scoop/Epoch.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define SLOTS 1024
+#define READS 2000000 /* per reader thread */
+#define REPEATS 3 /* the best of which is kept */
+
+/*
+ * A table of nodes, read by a number of threads while one thread
+ * replaces nodes in it, with the nodes found either in a read section
+ * and retired when replaced, or under a mutex and deleted at once.
+ */
+
+#define Node_ long value;
+#define Node__
+_SCOclassdef(Node);
+_SCOmetainst(Node, scoNone, 0, 0);
+
+_SCOctordef(Node, Node,, (Node *o, long value), (o, value))
+{
+	o->value = value;
+	return 1;
+}
+
+static Node *table[SLOTS];
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+static int use_epoch, stop;
+static long replacements;
+static __thread long bench_sink;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *reader(void *arg)
+{
+	unsigned int seed = (unsigned int)(size_t) arg;
+	long sum = 0;
+	int i;
+	if (use_epoch)
+		sco_epoch_register();
+	for (i = 0; i < READS; ++i) {
+		Node *node;
+		seed = seed * 1103515245 + 12345;
+		if (use_epoch) {
+			sco_epoch_enter();
+			node = __atomic_load_n(&table[(seed >> 8) % SLOTS],
+					__ATOMIC_ACQUIRE);
+			sum += node->value;
+			sco_epoch_exit();
+		} else {
+			pthread_mutex_lock(&table_lock);
+			node = table[(seed >> 8) % SLOTS];
+			sum += node->value;
+			pthread_mutex_unlock(&table_lock);
+		}
+	}
+	if (use_epoch)
+		sco_epoch_unregister();
+	bench_sink += sum;
+	return 0;
+}
+
+static void *writer(void *arg)
+{
+	unsigned int seed = 1;
+	long count = 0;
+	(void) arg;
+	while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+		Node *node = Node_new(0, count), *old;
+		size_t slot;
+		seed = seed * 1103515245 + 12345;
+		slot = (seed >> 8) % SLOTS;
+		if (use_epoch) {
+			old = __atomic_exchange_n(&table[slot], node,
+					__ATOMIC_ACQ_REL);
+			sco_retire(old);
+		} else {
+			pthread_mutex_lock(&table_lock);
+			old = table[slot];
+			table[slot] = node;
+			pthread_mutex_unlock(&table_lock);
+			sco_delete(old);
+		}
+		++count;
+	}
+	replacements = count;
+	return 0;
+}
+
+/* runs \p readers reader threads alongside the writer, giving reads
+ * per microsecond, and replacements per millisecond in \p writes */
+static double run(int readers, double *writes)
+{
+	pthread_t thread[readers], write_thread;
+	double t;
+	int i;
+	stop = 0;
+	pthread_create(&write_thread, 0, writer, 0);
+	t = now();
+	for (i = 0; i < readers; ++i)
+		pthread_create(&thread[i], 0, reader, (void*)(size_t)(i + 1));
+	for (i = 0; i < readers; ++i)
+		pthread_join(thread[i], 0);
+	t = now() - t;
+	__atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+	pthread_join(write_thread, 0);
+	if (use_epoch)
+		sco_epoch_sync();
+	*writes = replacements / t * 1e-3;
+	return (double) READS * readers / t * 1e-6;
+}
+
+static void measure(const char *what, int readers)
+{
+	double reads, writes, best = 0, best_writes = 0;
+	int r;
+	for (r = 0; r < REPEATS; ++r) {
+		reads = run(readers, &writes);
+		if (r == 0 || reads > best) {
+			best = reads;
+			best_writes = writes;
+		}
+	}
+	printf("%-22s %d readers %8.2f reads/us %8.1f replacements/ms\n",
+			what, readers, best, best_writes);
+}
+
+/*
+ * Times random reads of the table by 1, 2 and 4 threads while another
+ * thread keeps replacing nodes, for each way of protecting the reads.
+ */
+int main()
+{
+	static const int reader_counts[] = {1, 2, 4};
+	size_t i;
+	for (i = 0; i < SLOTS; ++i)
+		table[i] = Node_new(0, i);
+	for (i = 0; i < sizeof(reader_counts) / sizeof(*reader_counts); ++i) {
+		use_epoch = 1;
+		measure("epoch reclamation", reader_counts[i]);
+		use_epoch = 0;
+		measure("mutex", reader_counts[i]);
+	}
+	for (i = 0; i < SLOTS; ++i)
+		sco_delete(table[i]);
+	return 0;
+}
@@ -0,0 +1,147 @@
+/* Benchmark for SCOOP parallel calls, calling a virtual method for each
+ * object in a mixed array, with 1, 2 and 4 threads
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <scoop/Object.h>
+#include <scoop/Parallel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define COUNT 1000000
+#define REPEATS 3 /* the best of which is kept */
+
+/*
+ * Four classes doing different amounts of work per call, so that the
+ * cost of a range depends on the mix of objects in it.
+ */
+
+#define Work_ unsigned long state;
+#define Work__ void (*step)(void *o, void *arg);
+_SCOclassdef(Work);
+_SCOmetainst(Work, scoNone, 0, 0);
+
+static unsigned long spin(unsigned long x, int rounds)
+{
+	while (rounds--)
+		x = x * 6364136223846793005UL + 1442695040888963407UL;
+	return x;
+}
+
+#define WORK_CLASS(Class, rounds) \
+static void Class##_step(void *o, void *arg) \
+{ \
+	(void) arg; \
+	((Work*)o)->state = spin(((Work*)o)->state, rounds); \
+} \
+static void Class##_vtinit(Class##_Meta *o) \
+{ \
+	o->virt.step = Class##_step; \
+}
+
+#define Work1_ Work_
+#define Work1__ Work__
+_SCOclassdef(Work1);
+WORK_CLASS(Work1, 10)
+_SCOmetainst(Work1, Work, 0, Work1_vtinit);
+
+#define Work2_ Work_
+#define Work2__ Work__
+_SCOclassdef(Work2);
+WORK_CLASS(Work2, 20)
+_SCOmetainst(Work2, Work, 0, Work2_vtinit);
+
+#define Work3_ Work_
+#define Work3__ Work__
+_SCOclassdef(Work3);
+WORK_CLASS(Work3, 40)
+_SCOmetainst(Work3, Work, 0, Work3_vtinit);
+
+#define Work4_ Work_
+#define Work4__ Work__
+_SCOclassdef(Work4);
+WORK_CLASS(Work4, 80)
+_SCOmetainst(Work4, Work, 0, Work4_vtinit);
+
+static Work *objs[COUNT], *mixed[COUNT];
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* times calls for all objects, in the mixed order, giving the best in
+ * objects per microsecond; a NULL pool and no flags means sco_virt() */
+static double run(scoParallel *pool, int threads, int flags)
+{
+	double t, best = 0;
+	size_t i;
+	int r;
+	for (r = 0; r < REPEATS; ++r) {
+		memcpy(objs, mixed, sizeof(objs));
+		t = now();
+		if (threads)
+			sco_parallel_virt(pool, step, objs, COUNT, 0, flags, 0);
+		else
+			for (i = 0; i < COUNT; ++i)
+				sco_virt(step, objs[i], 0);
+		t = now() - t;
+		if (COUNT / t * 1e-6 > best)
+			best = COUNT / t * 1e-6;
+	}
+	return best;
+}
+
+/*
+ * Times calling a virtual method for each of COUNT objects of four
+ * classes in random order, in a plain loop and by the parallel calls
+ * with 1, 2 and 4 threads, with and without grouping by class.
+ */
+int main()
+{
+	static const int thread_counts[] = {1, 2, 4};
+	void *metas[4] = {sco_metaof(Work1), sco_metaof(Work2),
+		sco_metaof(Work3), sco_metaof(Work4)};
+	size_t i;
+	srand(1);
+	for (i = 0; i < COUNT; ++i)
+		mixed[i] = sco_raw_new(0, metas[rand() % 4]);
+	printf("sco_virt() loop %22.2f objects/us\n", run(0, 0, 0));
+	for (i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); ++i) {
+		scoParallel *pool = sco_parallel_create(thread_counts[i]);
+		if (!pool)
+			return 1;
+		printf("parallel, %d threads %17.2f objects/us\n",
+				thread_counts[i],
+				run(pool, thread_counts[i], 0));
+		printf("parallel, %d threads, grouped %8.2f objects/us\n",
+				thread_counts[i], run(pool, thread_counts[i],
+					SCO_PARALLEL_GROUP));
+		sco_parallel_destroy(pool);
+	}
+	for (i = 0; i < COUNT; ++i)
+		sco_delete(mixed[i]);
+	return 0;
+}
@@ -0,0 +1,156 @@
+/* Benchmark for SCOOP pool allocation with per-thread magazines, creating
+ * objects in some threads and deleting them in others
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <scoop/Object.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+
+#define OBJECTS 1000000 /* per producer thread */
+#define BATCH 64 /* objects handed over at once */
+#define RING 16 /* batches in flight between a producer and consumer */
+#define REPEATS 3 /* the best of which is kept */
+
+/*
+ * Two classes of the same size, one pooled and one using calloc().
+ */
+
+#define Pooled_ long value; char pad[56];
+#define Pooled__
+_SCOclassdef(Pooled);
+_SCOmetainst(Pooled, scoNone, 0, 0, SCO_POOL);
+
+#define Plain_ long value; char pad[56];
+#define Plain__
+_SCOclassdef(Plain);
+_SCOmetainst(Plain, scoNone, 0, 0);
+
+/* a ring of batches from a producer to a consumer */
+struct pair {
+	void *meta;
+	void *batches[RING][BATCH];
+	unsigned long head, tail; /* written by consumer, producer */
+	pthread_barrier_t *barrier;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *producer(void *arg)
+{
+	struct pair *p = arg;
+	unsigned long n;
+	size_t i;
+	pthread_barrier_wait(p->barrier);
+	for (n = 0; n < OBJECTS / BATCH; ++n) {
+		void **batch = p->batches[n % RING];
+		while (n - __atomic_load_n(&p->head, __ATOMIC_ACQUIRE) >= RING)
+			sched_yield();
+		for (i = 0; i < BATCH; ++i)
+			batch[i] = sco_raw_new(0, p->meta);
+		__atomic_store_n(&p->tail, n + 1, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+static void *consumer(void *arg)
+{
+	struct pair *p = arg;
+	unsigned long n;
+	size_t i;
+	pthread_barrier_wait(p->barrier);
+	for (n = 0; n < OBJECTS / BATCH; ++n) {
+		void **batch = p->batches[n % RING];
+		while (__atomic_load_n(&p->tail, __ATOMIC_ACQUIRE) == n)
+			sched_yield();
+		for (i = 0; i < BATCH; ++i)
+			sco_delete(batch[i]);
+		__atomic_store_n(&p->head, n + 1, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+/* runs \p pairs producer and consumer pairs, giving the objects passed
+ * through per microsecond */
+static double run(void *meta, int pairs)
+{
+	static struct pair pair[4];
+	pthread_t thread[2 * 4];
+	pthread_barrier_t barrier;
+	double t;
+	int i;
+	pthread_barrier_init(&barrier, 0, 2 * pairs + 1);
+	for (i = 0; i < pairs; ++i) {
+		pair[i].meta = meta;
+		pair[i].head = pair[i].tail = 0;
+		pair[i].barrier = &barrier;
+		pthread_create(&thread[2 * i], 0, producer, &pair[i]);
+		pthread_create(&thread[2 * i + 1], 0, consumer, &pair[i]);
+	}
+	pthread_barrier_wait(&barrier);
+	t = now();
+	for (i = 0; i < 2 * pairs; ++i)
+		pthread_join(thread[i], 0);
+	t = now() - t;
+	pthread_barrier_destroy(&barrier);
+	return (double) OBJECTS / BATCH * BATCH * pairs / t * 1e-6;
+}
+
+static void measure(const char *what, void *meta, int pairs)
+{
+	double rate, best = 0;
+	int r;
+	for (r = 0; r < REPEATS; ++r) {
+		rate = run(meta, pairs);
+		if (rate > best) best = rate;
+	}
+	printf("%-20s %d producers, %d consumers %8.2f objects/us\n",
+			what, pairs, pairs, best);
+}
+
+/*
+ * Times passing objects from producer threads, which create them, to
+ * consumer threads, which delete them, for 1, 2 and 4 pairs of threads.
+ */
+int main()
+{
+	static const int pair_counts[] = {1, 2, 4};
+	scoPoolStats stats;
+	size_t i;
+	for (i = 0; i < sizeof(pair_counts) / sizeof(*pair_counts); ++i) {
+		measure("pool with magazines", sco_metaof(Pooled),
+				pair_counts[i]);
+		measure("calloc()/free()", sco_metaof(Plain), pair_counts[i]);
+	}
+	if (sco_pool_stats(sco_metaof(Pooled), &stats))
+		printf("pool: %zu slots in %zu slabs, %zu used, "
+				"%zu cached, %zu allocations\n",
+				stats.slots, stats.slabs, stats.used,
+				stats.cached, stats.allocs);
+	return 0;
+}
@@ -0,0 +1,157 @@
+/* Benchmark for the SCOOP Ref module, comparing biased reference counting
+ * with plain atomic counts
+ * of objects of the test classes, and reporting the throughput in MB/s
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <scoop/Ref.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define PAIRS 10000000 /* retain/release pairs per thread */
+#define REPEATS 5 /* the best of which is kept */
+
+/*
+ * A reference-counted class, and one counted with plain atomics as
+ * done without the Ref module.
+ */
+
+#define Biased_ scoRef_ int value;
+#define Biased__ scoRef__
+_SCOclassdef(Biased);
+_SCOmetainst(Biased, scoRef, 0, 0);
+
+_SCOctordef(Biased, Biased,, (Biased *o), (o))
+{
+	sco_Ref_ctor((scoRef*)o);
+	return 1;
+}
+
+#define Atomic_ int refs; int value;
+#define Atomic__
+_SCOclassdef(Atomic);
+_SCOmetainst(Atomic, scoNone, 0, 0);
+
+_SCOctordef(Atomic, Atomic,, (Atomic *o), (o))
+{
+	o->refs = 1;
+	return 1;
+}
+
+static void *atomic_retain(void *o)
+{
+	__atomic_fetch_add(&((Atomic*)o)->refs, 1, __ATOMIC_RELAXED);
+	return o;
+}
+
+static void atomic_release(void *o)
+{
+	if (!__atomic_sub_fetch(&((Atomic*)o)->refs, 1, __ATOMIC_ACQ_REL))
+		sco_delete(o);
+}
+
+struct job {
+	void *(*retain)(void *o);
+	void (*release)(void *o);
+	void *obj;
+	pthread_barrier_t *barrier;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *worker(void *arg)
+{
+	struct job *job = arg;
+	int i;
+	pthread_barrier_wait(job->barrier);
+	for (i = 0; i < PAIRS; ++i)
+		job->release(job->retain(job->obj));
+	return 0;
+}
+
+/* runs \p threads threads of pairs on \p obj, or just the calling
+ * thread if zero, giving the time per pair */
+static double run(struct job job, int threads)
+{
+	pthread_t thread[threads ? threads : 1];
+	pthread_barrier_t barrier;
+	double t;
+	int i;
+	pthread_barrier_init(&barrier, 0, threads ? threads : 1);
+	job.barrier = &barrier;
+	t = now();
+	if (!threads) {
+		worker(&job);
+	} else {
+		for (i = 0; i < threads; ++i)
+			pthread_create(&thread[i], 0, worker, &job);
+		for (i = 0; i < threads; ++i)
+			pthread_join(thread[i], 0);
+	}
+	t = now() - t;
+	pthread_barrier_destroy(&barrier);
+	return t * 1e9 / PAIRS;
+}
+
+static void measure(const char *what, struct job job, int threads)
+{
+	double t, best = 0;
+	int r;
+	for (r = 0; r < REPEATS; ++r) {
+		t = run(job, threads);
+		if (r == 0 || t < best) best = t;
+	}
+	if (threads)
+		printf("%-28s %2d threads %8.2f ns per pair\n", what,
+				threads, best);
+	else
+		printf("%-28s owner      %8.2f ns per pair\n", what, best);
+}
+
+/*
+ * Times retain/release pairs in the thread owning the object, then in
+ * other threads sharing it, for each kind of count.
+ */
+int main()
+{
+	static const int thread_counts[] = {1, 2, 4};
+	struct job biased = {sco_retain, sco_release, 0, 0};
+	struct job atomic = {atomic_retain, atomic_release, 0, 0};
+	size_t i;
+	biased.obj = Biased_new(0);
+	atomic.obj = Atomic_new(0);
+	measure("sco_retain()/sco_release()", biased, 0);
+	measure("plain atomics", atomic, 0);
+	for (i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); ++i) {
+		measure("sco_retain()/sco_release()", biased,
+				thread_counts[i]);
+		measure("plain atomics", atomic, thread_counts[i]);
+	}
+	sco_release(biased.obj);
+	atomic_release(atomic.obj);
+	return 0;
+}
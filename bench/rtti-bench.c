@@ -0,0 +1,164 @@
+/* Microbenchmark for SCOOP RTTI checks, comparing a linear walk up the
+ * superclass chain with the superclass display lookup of sco_rtticheck()
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Object.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CHECKS 10000000
+#define DEPTH_MAX 16
+
+/*
+ * A class hierarchy 17 levels deep, C0 - C16, and an unrelated class U.
+ */
+
+#define C0_ int v;
+#define C0__
+_SCOclassdef(C0);
+_SCOmetainst(C0, scoNone, 0, 0);
+
+#define LEVELDEF(Class, Superclass) \
+_SCOclassdef(Class); \
+_SCOmetainst(Class, Superclass, 0, 0)
+
+#define C1_ C0_
+#define C1__ C0__
+LEVELDEF(C1, C0);
+#define C2_ C1_
+#define C2__ C1__
+LEVELDEF(C2, C1);
+#define C3_ C2_
+#define C3__ C2__
+LEVELDEF(C3, C2);
+#define C4_ C3_
+#define C4__ C3__
+LEVELDEF(C4, C3);
+#define C5_ C4_
+#define C5__ C4__
+LEVELDEF(C5, C4);
+#define C6_ C5_
+#define C6__ C5__
+LEVELDEF(C6, C5);
+#define C7_ C6_
+#define C7__ C6__
+LEVELDEF(C7, C6);
+#define C8_ C7_
+#define C8__ C7__
+LEVELDEF(C8, C7);
+#define C9_ C8_
+#define C9__ C8__
+LEVELDEF(C9, C8);
+#define C10_ C9_
+#define C10__ C9__
+LEVELDEF(C10, C9);
+#define C11_ C10_
+#define C11__ C10__
+LEVELDEF(C11, C10);
+#define C12_ C11_
+#define C12__ C11__
+LEVELDEF(C12, C11);
+#define C13_ C12_
+#define C13__ C12__
+LEVELDEF(C13, C12);
+#define C14_ C13_
+#define C14__ C13__
+LEVELDEF(C14, C13);
+#define C15_ C14_
+#define C15__ C14__
+LEVELDEF(C15, C14);
+#define C16_ C15_
+#define C16__ C15__
+LEVELDEF(C16, C15);
+#define U_ int v;
+#define U__
+LEVELDEF(U, scoNone);
+
+static void *const chain[DEPTH_MAX + 1] = {
+	sco_metaof(C0), sco_metaof(C1), sco_metaof(C2), sco_metaof(C3),
+	sco_metaof(C4), sco_metaof(C5), sco_metaof(C6), sco_metaof(C7),
+	sco_metaof(C8), sco_metaof(C9), sco_metaof(C10), sco_metaof(C11),
+	sco_metaof(C12), sco_metaof(C13), sco_metaof(C14), sco_metaof(C15),
+	sco_metaof(C16),
+};
+
+/* the old sco_rtticheck(), walking up the superclass chain */
+__attribute__((noinline))
+static int rtticheck_walk(const void *submeta, const void *meta)
+{
+	const scoObject_Meta *subclass = submeta, *class = meta;
+	if (subclass == class)
+		return 0;
+	do {
+		subclass = subclass->super;
+		if (subclass == class)
+			return 1;
+	} while (subclass);
+	return -1;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* returns nanoseconds per check of \p sub against \p meta */
+static double time_checks(int (*check)(const void*, const void*),
+		void *sub, void *meta)
+{
+	/* the volatile pointer keeps the loop from being optimized away */
+	void *volatile sub_v = sub;
+	double t = now();
+	int i, sum = 0;
+	for (i = 0; i < CHECKS; ++i)
+		sum += check(sub_v, meta);
+	t = now() - t;
+	if (sum == 42) putchar(' ');
+	return t * 1e9 / CHECKS;
+}
+
+int main()
+{
+	int depth;
+	/* initialize all meta types by allocating instances */
+	for (depth = 0; depth <= DEPTH_MAX; ++depth)
+		sco_delete(sco_raw_new(0, chain[depth]));
+	sco_delete(sco_raw_new(0, sco_metaof(U)));
+
+	puts("ns per check of a class at depth against its base class, "
+			"and against an unrelated class");
+	printf("%5s %12s %12s %12s %12s\n", "depth",
+			"walk base", "display base",
+			"walk none", "display none");
+	for (depth = 1; depth <= DEPTH_MAX; ++depth) {
+		void *sub = chain[depth];
+		printf("%5d %12.2f %12.2f %12.2f %12.2f\n", depth,
+			time_checks(rtticheck_walk, sub, chain[0]),
+			time_checks(sco_rtticheck, sub, chain[0]),
+			time_checks(rtticheck_walk, sub, sco_metaof(U)),
+			time_checks(sco_rtticheck, sub, sco_metaof(U)));
+	}
+	return 0;
+}
@@ -0,0 +1,234 @@
+/* Benchmark for SCOOP serialization, writing and reading a large graph
+ * of objects of the test classes, and reporting the throughput in MB/s
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Serial.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NODES 1000000
+#define REPEATS 5 /* the best of which is kept */
+#define PIECE 65536 /* bytes per read() call when streaming */
+
+/*
+ * The classes of the Serial test: nodes with two object pointers,
+ * leaves adding some data, and points written as plain data.
+ */
+
+#define Node_ int value; void *next; void *other;
+#define Node__
+_SCOclassdef(Node);
+
+static const scoField Node_fields[] = {
+	SCO_FIELD(Node, value),
+	SCO_FIELD_OBJ(Node, next),
+	SCO_FIELD_OBJ(Node, other),
+	SCO_FIELD_END
+};
+
+static void Node_vtinit(Node_Meta *o)
+{
+	o->fields = Node_fields;
+}
+
+_SCOmetainst(Node, scoNone, 0, Node_vtinit);
+
+#define Leaf_ Node_ double weight; char tag[8];
+#define Leaf__ Node__
+_SCOclassdef(Leaf);
+
+static const scoField Leaf_fields[] = {
+	SCO_FIELD(Leaf, weight),
+	SCO_FIELD(Leaf, tag),
+	SCO_FIELD_END
+};
+
+static void Leaf_vtinit(Leaf_Meta *o)
+{
+	o->fields = Leaf_fields;
+}
+
+_SCOmetainst(Leaf, Node, 0, Leaf_vtinit);
+
+#define Point_ float x, y, z;
+#define Point__
+_SCOclassdef(Point);
+_SCOmetainst(Point, scoNone, 0, 0);
+
+static void *const metas[] = {
+	sco_metaof(Node), sco_metaof(Leaf), sco_metaof(Point)
+};
+
+static Node *nodes[NODES];
+static Point *points[NODES / 4];
+
+typedef struct Buffer {
+	unsigned char *data;
+	size_t size, alloc, pos;
+} Buffer;
+
+static int buffer_write(void *arg, const void *data, size_t size)
+{
+	Buffer *o = arg;
+	if (o->size + size > o->alloc) {
+		size_t alloc = (o->size + size) * 2;
+		unsigned char *p = realloc(o->data, alloc);
+		if (!p)
+			return 0;
+		o->data = p;
+		o->alloc = alloc;
+	}
+	memcpy(o->data + o->size, data, size);
+	o->size += size;
+	return 1;
+}
+
+static size_t buffer_read(void *arg, void *data, size_t size)
+{
+	Buffer *o = arg;
+	if (size > PIECE) size = PIECE;
+	if (size > o->size - o->pos) size = o->size - o->pos;
+	memcpy(data, o->data + o->pos, size);
+	o->pos += size;
+	return size;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* a list of nodes, every fourth a leaf and every fourth pointing to a
+ * point, and the others to random nodes */
+static void make_graph(void)
+{
+	unsigned int seed = 1;
+	size_t i;
+	for (i = 0; i < NODES; ++i) {
+		nodes[i] = sco_raw_new(0, (i % 4) ? (void*)sco_metaof(Node) :
+				(void*)sco_metaof(Leaf));
+		nodes[i]->value = (int) i;
+		if (!(i % 4)) {
+			Leaf *leaf = (Leaf*)nodes[i];
+			leaf->weight = i * 0.5;
+			strcpy(leaf->tag, "leaf");
+		}
+	}
+	for (i = 0; i < NODES; ++i) {
+		nodes[i]->next = (i + 1 < NODES) ? nodes[i + 1] : 0;
+		if (i % 4 == 1) {
+			Point *p = points[i / 4] = sco_raw_new(0,
+					sco_metaof(Point));
+			p->x = p->y = p->z = (float) i;
+			nodes[i]->other = p;
+		} else {
+			seed = seed * 1103515245 + 12345;
+			nodes[i]->other = nodes[(seed >> 8) % NODES];
+		}
+	}
+}
+
+/* deletes the copy of the graph read, in the same shape */
+static void delete_copy(Node *head)
+{
+	size_t i = 0;
+	while (head) {
+		Node *next = head->next;
+		if (i++ % 4 == 1)
+			sco_delete(head->other);
+		sco_delete(head);
+		head = next;
+	}
+}
+
+static void report(const char *what, size_t bytes, double t)
+{
+	printf("%-32s %8.1f MB/s, %6.1f ns per object\n", what,
+			bytes / t * 1e-6, t * 1e9 / (NODES + NODES / 4));
+}
+
+int main()
+{
+	Buffer buf = {0};
+	void *root;
+	double t, best;
+	size_t i;
+	int r;
+	make_graph();
+	root = nodes[0];
+
+	best = 0;
+	for (r = 0; r < REPEATS; ++r) {
+		buf.size = 0;
+		t = now();
+		if (!sco_serialize(&root, 1, buffer_write, &buf)) {
+			fputs("serialization failed\n", stderr);
+			return 1;
+		}
+		t = now() - t;
+		if (r == 0 || t < best) best = t;
+	}
+	printf("%d objects in %zu bytes\n", NODES + NODES / 4, buf.size);
+	report("sco_serialize()", buf.size, best);
+
+	best = 0;
+	for (r = 0; r < REPEATS; ++r) {
+		void *copy;
+		t = now();
+		if (!sco_deserialize_mem(&copy, 1, buf.data, buf.size,
+					metas, 3)) {
+			fputs("deserialization failed\n", stderr);
+			return 1;
+		}
+		t = now() - t;
+		if (r == 0 || t < best) best = t;
+		delete_copy(copy);
+	}
+	report("sco_deserialize_mem()", buf.size, best);
+
+	best = 0;
+	for (r = 0; r < REPEATS; ++r) {
+		void *copy;
+		buf.pos = 0;
+		t = now();
+		if (!sco_deserialize(&copy, 1, buffer_read, &buf, metas, 3)) {
+			fputs("deserialization failed\n", stderr);
+			return 1;
+		}
+		t = now() - t;
+		if (r == 0 || t < best) best = t;
+		delete_copy(copy);
+	}
+	report("sco_deserialize(), streamed", buf.size, best);
+
+	for (i = 0; i < NODES; ++i)
+		sco_delete(nodes[i]);
+	for (i = 0; i < NODES / 4; ++i)
+		sco_delete(points[i]);
+	free(buf.data);
+	return 0;
+}
@@ -0,0 +1,146 @@
+/* SCOOP Actor module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Actor_h
+#define scoop_Actor_h
+#include "Object.h"
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Actors, objects whose virtual methods are called asynchronously by
+   sending them messages, run by a pool of worker threads.
+
+   A class which derives from scoActor (listing scoActor_ first in its
+   member list, and scoActor__ first in its virtual list) gets a mailbox.
+   Its constructors must call sco_Actor_ctor(), giving the worker pool
+   which is to run its messages. Message handlers are virtual methods of
+   the form
+
+       void (*handle)(void *o, void *arg);
+
+   (see \ref scoHandler), and sco_send() queues a call to one for an
+   actor, to be made by a worker thread. Messages to an actor are run
+   one at a time, in the order sent from each thread, so that handlers
+   need no locking of the actor's own data, and the class can be written
+   as for a single thread. Different actors run in parallel.
+
+   Sending pushes the message onto the mailbox without locking; only
+   when the actor is idle is it also put in the run queue of the pool,
+   under its lock. A worker then runs all messages in the mailbox at the
+   time, before moving on to the next actor in the queue.
+
+   An actor must not be deleted while messages to it are pending or
+   running, e.g. until after sco_workers_wait(). Messages are
+   allocated from a pool (see \ref SCO_POOL), so that sending and
+   running them usually takes no lock in the memory allocator.
+ */
+
+/** Message handler function pointer type. \p arg is the argument given
+  * to sco_send(), or the copy of the data given to sco_send_copy(). */
+typedef void (*scoHandler)(void *o, void *arg);
+
+/** A pool of worker threads running the messages of actors. */
+typedef struct scoWorkers scoWorkers;
+
+/** Maximum size of data copied into a message by sco_send_copy(). */
+#define SCO_MESSAGE_DATA 48
+
+/** The member list of scoActor. The members are private. */
+#define scoActor_ \
+	scoWorkers *actor_workers; /* running its messages */ \
+	struct scoMessage *actor_mail; /* pending, newest first */ \
+	struct scoActor *actor_next; /* in run queue */ \
+	unsigned char actor_queued; /* set while in queue or running */
+
+/** The virtual method list of scoActor, which is empty. */
+#define scoActor__
+
+SCOclassdef(scoActor);
+
+/** Constructs an actor, whose messages are to be run by \p workers.
+  * Always succeeds. */
+SCOctordec(scoActor, sco_Actor,, (scoActor *o, scoWorkers *workers));
+
+/** Creates a pool of \p threads worker threads, or one per CPU if zero.
+  *
+  * Returns the pool, or NULL if memory allocation or thread creation
+  * failed.
+  */
+SCO_API scoWorkers *sco_workers_create(unsigned int threads);
+
+/** Waits until every message sent has been run, including those sent
+  * by handlers meanwhile. Other threads must not send messages to the
+  * pool's actors while waiting.
+  */
+SCO_API void sco_workers_wait(scoWorkers *o);
+
+/** Runs all pending messages, then stops and joins the threads and
+  * frees the pool.
+  */
+SCO_API void sco_workers_destroy(scoWorkers *o);
+
+/** Queue a call of the handler \p func, a virtual method of actor \p o,
+  * passing \p arg.
+  *
+  * Evaluates to non-zero, or zero if memory allocation failed.
+  */
+#define sco_send(func, o, arg) \
+	sco_actor_post((o), SCO__HANDLER_SLOT(func, o), (arg))
+
+/** Queue a call of the handler \p func, a virtual method of actor \p o,
+  * passing a copy of the \p size bytes at \p data, at most
+  * \ref SCO_MESSAGE_DATA. The copy is kept in the message.
+  *
+  * Evaluates to non-zero, or zero if memory allocation failed or
+  * \p size is too large.
+  */
+#define sco_send_copy(func, o, data, size) \
+	sco_actor_post_copy((o), SCO__HANDLER_SLOT(func, o), (data), (size))
+
+/* the index of the handler in the virtual table, after checking its
+ * type */
+#define SCO__HANDLER_SLOT(func, o) \
+	((void)sizeof((o)->meta->virt.func == (scoHandler)0), \
+	 (offsetof(__typeof__(*(o)->meta), virt.func) - \
+	  offsetof(__typeof__(*(o)->meta), virt)) / sizeof(void (*)()))
+
+/** Queues a call of the handler in slot \p slot of the virtual table
+  * of actor \p o, passing \p arg. Used by sco_send().
+  *
+  * Returns non-zero, or zero if memory allocation failed.
+  */
+SCO_API int sco_actor_post(void *o, size_t slot, void *arg);
+
+/** Like sco_actor_post(), but passing a copy of \p size bytes at
+  * \p data. Used by sco_send_copy().
+  */
+SCO_API int sco_actor_post_copy(void *o, size_t slot, const void *data,
+		size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,101 @@
+/* SCOOP Arena module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Arena_h
+#define scoop_Arena_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Region allocation for SCOOP objects (and any other data), meant for
+   large sets of objects which are all destroyed at the same time.
+
+   Memory is taken from large chunks by bumping a pointer, and objects of
+   classes with destructors (or tracked, see \ref SCO_TRACK, or counted,
+   see scoop/Stats.h) are recorded in a compact list. Clearing or
+   destroying the arena then calls the destructors of those objects only,
+   in the reverse order of creation, and releases the memory chunk by
+   chunk rather than object by object.
+
+   Objects allocated in an arena are ordinary instances in all other
+   respects; virtual functions and RTTI checks work as usual. They must
+   not be passed to sco_delete(), but may be destroyed early using
+   sco_finalize(), in which case they are skipped when the arena is
+   cleared.
+
+   An arena is not thread-safe; use one per thread, or lock around it.
+ */
+
+/** Arena of memory chunks, with its list of objects to destroy. */
+typedef struct scoArena scoArena;
+
+/** Creates an arena allocating memory in chunks of \p chunk_size bytes.
+  * If \p chunk_size is zero, a default size is used.
+  *
+  * Returns the arena, or NULL if memory allocation failed.
+  */
+SCO_API scoArena *sco_arena_create(size_t chunk_size);
+
+/** Destroys all objects in the arena (see sco_arena_clear()) and then
+  * frees all of its memory, including the arena itself.
+  */
+SCO_API void sco_arena_destroy(scoArena *o);
+
+/** Calls the destructors for all objects allocated in the arena,
+  * newest first, and frees all memory but the first chunk, which is
+  * kept for reuse. The arena is then empty.
+  */
+SCO_API void sco_arena_clear(scoArena *o);
+
+/** Allocates \p size bytes of zero'd memory in the arena, suitably
+  * aligned for any type. Such memory is not tracked in any way, and
+  * is simply released along with the rest of the arena.
+  *
+  * Returns the memory, or NULL if memory allocation failed.
+  */
+SCO_API void *sco_arena_alloc(scoArena *o, size_t size);
+
+/** Allocates zero'd memory for an instance of the class given by
+  * \p meta from the arena, aligned as the class requires (see
+  * \ref SCO_CACHELINE), and sets its \a meta pointer. If the class or a
+  * superclass of it has a destructor, or the class is tracked or counted,
+  * the instance is recorded for destruction along with the arena.
+  *
+  * The memory is then to be passed to a *_new() function for the class,
+  * e.g. Foo_new(sco_arena_raw_new(arena, sco_metaof(Foo)), ...), which
+  * creates the instance in it. (Or to sco_raw_new(), and then to a
+  * *_ctor() function.) Only that does the per-instance work of
+  * sco_raw_new(), such as listing the instance of a tracked class (see
+  * \ref SCO_TRACK), so that it is done once. If construction fails, the
+  * instance is not destroyed with the arena.
+  *
+  * Returns the memory, or NULL if memory allocation failed.
+  */
+SCO_API void *sco_arena_raw_new(scoArena *o, void *meta);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
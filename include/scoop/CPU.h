@@ -0,0 +1,92 @@
+/* SCOOP CPU module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef scoop_CPU_h
+#define scoop_CPU_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Selection of virtual method implementations by CPU features.
+
+   A class with several versions of a method, each built for a different
+   instruction set extension, lists them in a table from the most to the
+   least demanding, ending with a version which needs no extensions:
+
+       static const scoCPUImpl sum_impls[] = {
+         {SCO_CPU_AVX2, (scoCPUFunc) Vec_sum_avx2},
+         {SCO_CPU_SSE2, (scoCPUFunc) Vec_sum_sse2},
+         {0, (scoCPUFunc) Vec_sum},
+       };
+
+   Its vtinit function (see SCOmetainst()) then sets the method using
+   sco_cpu_pick(o->virt.sum, sum_impls). As vtinit is called once, when
+   the class is initialized, the virtual table points straight at the
+   best version for the host, and calls have no further cost.
+
+   The features of the host are detected once. The environment variable
+   SCO_CPU can name a lower feature level to use instead: "none" for
+   no extensions, or the name of a feature in the list below (e.g.
+   "sse2" or "avx2") for it and all before it, as far as present.
+ */
+
+/** Feature flags, in order of level; see sco_cpu_features(). */
+#define SCO_CPU_SSE2    0x0001
+#define SCO_CPU_SSE4_2  0x0002
+#define SCO_CPU_AVX     0x0004
+#define SCO_CPU_AVX2    0x0008
+#define SCO_CPU_AVX512F 0x0010
+
+/** Gets the feature flags for the instruction set extensions which are
+  * present and usable, limited by the SCO_CPU environment variable if
+  * set. Zero on CPUs other than x86.
+  */
+SCO_API unsigned int sco_cpu_features(void);
+
+/** Generic function pointer type for scoCPUImpl. */
+typedef void (*scoCPUFunc)(void);
+
+/** Version of a function, with the features it requires. */
+typedef struct scoCPUImpl {
+	unsigned int features;
+	scoCPUFunc func;
+} scoCPUImpl;
+
+/** Returns the function of the first entry in \p impls whose features
+  * are all available. The table must end with an entry requiring none.
+  */
+SCO_API scoCPUFunc sco_cpu_select(const scoCPUImpl *impls);
+
+/** Sets the function pointer \p slot to the version selected from the
+  * table \p impls by sco_cpu_select().
+  */
+#define sco_cpu_pick(slot, impls) \
+	((void)((slot) = (__typeof__(slot)) sco_cpu_select(impls)))
+
+#ifdef __cplusplus
+}
+#endif
+#endif
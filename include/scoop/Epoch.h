@@ -0,0 +1,102 @@
+/* SCOOP Epoch module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Epoch_h
+#define scoop_Epoch_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Epoch-based reclamation, for deleting objects which threads may still
+   be reading without locks.
+
+   A thread which reads shared objects without taking a lock registers
+   using sco_epoch_register(), and then reads between calls to
+   sco_epoch_enter() and sco_epoch_exit(), holding on to no pointers to
+   shared objects outside of such a read section. Between read sections,
+   the thread is in a quiescent state.
+
+   A thread which unlinks an object, so that no new reader can find it,
+   passes it to sco_retire() rather than sco_delete(). It is then queued,
+   and deleted (its destructors called and its memory freed, as by
+   sco_delete()) only once every registered thread has been quiescent
+   at least once since. Deletion happens in whichever thread finds that
+   enough time has passed, in batches: on retiring, every so often, or on
+   calling sco_epoch_reclaim() or sco_epoch_sync().
+
+   Read sections are cheap, costing a store and a memory fence on entry
+   and a store on exit. A thread which stays in a read section for long
+   keeps every object retired in the meantime from being deleted.
+ */
+
+/** Registers the calling thread as a reader. Must be called by each
+  * thread before its first call to sco_epoch_enter(). Calling it again
+  * does nothing.
+  *
+  * Returns non-zero, or zero if memory allocation failed.
+  */
+SCO_API int sco_epoch_register(void);
+
+/** Unregisters the calling thread, which should be done by a reader
+  * thread before it exits, so that its record can be reused. Must not
+  * be called in a read section.
+  */
+SCO_API void sco_epoch_unregister(void);
+
+/** Begins a read section in the calling thread, which must be
+  * registered. Read sections may be nested, the thread being quiescent
+  * again once each has been ended by sco_epoch_exit().
+  */
+SCO_API void sco_epoch_enter(void);
+
+/** Ends a read section begun by sco_epoch_enter(). */
+SCO_API void sco_epoch_exit(void);
+
+/** Queues object \p o for deletion once no reader can be reading it,
+  * as described above. It must already be unlinked from wherever
+  * readers may find it, and be an instance which could be passed to
+  * sco_delete(). The calling thread need not be registered, and may be
+  * in a read section.
+  *
+  * Returns non-zero, or zero if memory allocation failed, in which case
+  * \p o is not queued.
+  */
+SCO_API int sco_retire(void *o);
+
+/** Deletes the retired objects which no reader can be reading any
+  * longer, without waiting for readers.
+  */
+SCO_API void sco_epoch_reclaim(void);
+
+/** Waits until every object retired before the call has been deleted,
+  * which may take as long as the longest read section in progress.
+  * Must not be called in a read section.
+  */
+SCO_API void sco_epoch_sync(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,169 @@
+/* SCOOP Iface module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Iface_h
+#define scoop_Iface_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Interfaces, for unrelated classes sharing a capability without a
+   common superclass declaring it.
+
+   An interface is a named table of functions, declared like the virtual
+   method list of a class:
+
+       #define Drawable__ \
+         void (*draw)(void *o, Canvas *c); \
+         void (*bounds)(void *o, Rect *r);
+       SCOifacedef(Drawable);
+
+   and defined once using SCOifaceinst(Drawable) (or declared and
+   defined at once for a single file using _SCOifacedef()). A class
+   implements it by filling in a Drawable_Iface table, and listing it
+   in the meta type from its vtinit function:
+
+       static const Drawable_Iface Circle_drawable = {
+         Circle_draw, Circle_bounds
+       };
+       static const scoImpl Circle_impls[] = {
+         SCO_IMPL(Drawable, &Circle_drawable),
+         SCO_IMPL_END
+       };
+       ... in vtinit: o->impls = Circle_impls;
+
+   Subclasses inherit the interfaces of their superclass, and may
+   override a table by listing the interface again. Only classes which
+   implement an interface pay for it, rather than every class in a
+   hierarchy carrying the functions in its virtual table.
+
+   sco_iface() looks up the table of an interface for an instance. Each
+   call site caches the last class and table found, so that repeated
+   lookups for the same class cost a single comparison. Otherwise, the
+   table is found in a per-class hash table without collisions, set up
+   when the class is initialized, in a few more steps.
+ */
+
+/** The identity of an interface, defined by SCOifaceinst(). */
+typedef struct scoIface {
+	const char *name;
+} scoIface;
+
+/** An interface implemented by a class, for the list of them set as
+  * the \a impls field of its meta type by vtinit. */
+typedef struct scoImpl {
+	const scoIface *iface;
+	const void *table;
+} scoImpl;
+
+/** An entry in the interface table of a class. */
+typedef struct scoIfaceEntry {
+	const void *meta; /* the class, or NULL if unused */
+	const scoIface *iface;
+	const void *table;
+} scoIfaceEntry;
+
+/** The interface table of a class, built on initialization. */
+typedef struct scoIfaceTable {
+	unsigned long long mult; /* hash multiplier */
+	unsigned int shift; /* hash shift, for a power of two entries */
+	scoIfaceEntry entries[];
+} scoIfaceTable;
+
+/** Declare the table type Name_Iface for the interface \p Name, from
+  * the function list in the macro Name__, and the identity defined by
+  * SCOifaceinst().
+  */
+#define SCOifacedef(Name) \
+typedef struct Name##_Iface { Name##__ } Name##_Iface; \
+SCO_USERAPI extern const scoIface _##Name##_iface
+
+/** Define the identity of the interface \p Name. */
+#define SCOifaceinst(Name) \
+const scoIface _##Name##_iface = {#Name}
+
+/** Like SCOifacedef() and SCOifaceinst() together, but for an interface
+  * only used within a single file.
+  */
+#define _SCOifacedef(Name) \
+typedef struct Name##_Iface { Name##__ } Name##_Iface; \
+static const scoIface _##Name##_iface = {#Name}
+
+/** Get the identity of the interface \p Name. */
+#define sco_ifaceof(Name) (&(_##Name##_iface))
+
+/** Entry for an interface list, giving the interface \p Name and the
+  * class's table for it. */
+#define SCO_IMPL(Name, table) \
+	{sco_ifaceof(Name), (const Name##_Iface*)(table)}
+
+/** Ends an interface list. */
+#define SCO_IMPL_END {0, 0}
+
+/** The entry found for classes not implementing an interface. */
+SCO_API extern const scoIfaceEntry sco_iface_none;
+
+/** Get the table of interface \p Name for instance \p o, as a pointer
+  * to a constant Name_Iface, or NULL if its class does not implement
+  * the interface.
+  *
+  * The class and entry found are cached for the call site, so that when
+  * called for instances of the same class, this costs a comparison.
+  */
+#define sco_iface(o, Name) __extension__ ({ \
+	static const scoIfaceEntry *SCO__ic = &sco_iface_none; \
+	const void *SCO__o = (o); \
+	const scoIfaceEntry *SCO__e = __atomic_load_n(&SCO__ic, \
+			__ATOMIC_RELAXED); \
+	if (SCO__e->meta != ((const scoObject*)SCO__o)->meta) { \
+		SCO__e = sco_iface_find(SCO__o, sco_ifaceof(Name)); \
+		if (SCO__e->meta) \
+			__atomic_store_n(&SCO__ic, SCO__e, __ATOMIC_RELAXED); \
+	} \
+	(const Name##_Iface*) SCO__e->table; \
+})
+
+/** Finds the entry for \p iface in the interface table of the class
+  * of \p o, without caching it. Its \a table is the table of the
+  * interface, or NULL (and the entry \ref sco_iface_none) if the class
+  * does not implement the interface.
+  */
+SCO_API const scoIfaceEntry *sco_iface_find(const void *o,
+		const scoIface *iface);
+
+/** Returns the table of \p iface for the class of \p o, or NULL if the
+  * class does not implement it. Like sco_iface() without caching. */
+SCO_API const void *sco_iface_get(const void *o, const scoIface *iface);
+
+/*
+ * Used by the Object module.
+ */
+
+SCO_API int sco_iface_init(void *meta);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
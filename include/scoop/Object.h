@@ -27,6 +27,7 @@
 # include "API.h"
 #endif
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdarg.h>
 #ifdef __cplusplus
 extern "C" {
@@ -56,7 +57,14 @@ extern "C" {
 
    There is no need to "register" a class before allocating an instance. The
    meta type will become fully initialized the first time an instance
-   is allocated.
+   is allocated. This may happen in any thread; if several threads race
+   to create the first instances of a class (or of classes sharing a
+   superclass), one of them performs the initialization while the others
+   wait for it to finish. (A vtinit function must therefore not allocate
+   instances of the class it initializes, though it may make RTTI checks
+   against it.) Initialized classes join the class registry (see
+   scoop/Registry.h), and sco_meta_init() can be used to initialize a
+   class before any instance is created.
 
    A note on the SCOOP API naming convention:
    - Declarations and definitions meant to mimic new keywords are named
@@ -130,12 +138,88 @@ typedef struct Name { const struct Name##_Meta *meta; Name##_ } Name
  */
 typedef void (*scoDtor)(void *o);
 
+/**
+ * Class default constructor function pointer type, see sco_proto_enable().
+ */
+typedef unsigned char (*scoCtor)(void *o);
+
+/**
+ * Class copy hook function pointer type, see sco_clone().
+ */
+typedef unsigned char (*scoCopy)(void *o, const void *src);
+
 /**
  * Meta type vtable initializer function pointer type.
  * The meta type instance is expected as the \p o argument.
  */
 typedef void (*scoVtinit)(void *o);
 
+/**
+ * Slab pool of instance memory for a class, see \ref SCO_POOL.
+ */
+struct scoPool;
+
+/**
+ * Per-class instance counters, see scoop/Stats.h.
+ */
+struct scoStats;
+
+/**
+ * List of the instances of a class, see \ref SCO_TRACK.
+ */
+struct scoTrack;
+
+/**
+ * Prototype instance of a class, see sco_proto_enable().
+ */
+struct scoProto;
+
+/**
+ * Description of a serialized member, see scoop/Serial.h.
+ */
+struct scoField;
+
+/**
+ * Interface implemented by a class, and lookup table of all those of a
+ * class, see scoop/Iface.h.
+ */
+struct scoImpl;
+struct scoIfaceTable;
+
+/**
+ * The number of entries in the superclass display of meta types, which
+ * makes RTTI checks constant-time for superclasses above this depth.
+ * (Checks against deeper superclasses walk up from the class checked.)
+ */
+#define SCO_DISPLAY_MAX 8
+
+#ifndef SCO_DOXYGEN
+/* the members of every meta type, before its virtual table */
+# define SCO__META_MEMBERS \
+	const struct scoObject_Meta *super; \
+	size_t size; \
+	unsigned short align; /* alignment of instances, raised on init */ \
+	unsigned short vnum; \
+	unsigned short vvoff, vvsize; /* offset and size of vars, if any */ \
+	unsigned char done; /* set once initialized, accessed atomically */ \
+	unsigned short flags; /* SCO_POOL, etc. */ \
+	unsigned short depth; /* number of superclasses, set on init */ \
+	unsigned int id; /* number in class registry, set on init */ \
+	const char *name; \
+	scoVtinit vtinit; /* virtual table init function, passed meta */ \
+	scoCopy copy; /* copy hook for sco_clone(), may be set by vtinit */ \
+	const struct scoField *fields; /* serialized, may be set by vtinit */ \
+	const struct scoImpl *impls; /* interfaces, may be set by vtinit */ \
+	const struct scoIfaceTable *ifaces; /* all interfaces, on init */ \
+	struct scoPool *pool; /* instance slab pool, if any */ \
+	struct scoStats *stats; /* instance counters, if SCO_STATS */ \
+	struct scoTrack *track; /* instance list, if SCO_TRACK */ \
+	const scoDtor *dtors; /* non-NULL dtors, most derived first, on init */ \
+	struct scoProto *proto; /* prototype instance, if enabled */ \
+	/* base class, its subclasses down to and including this, on init */ \
+	const struct scoObject_Meta *display[SCO_DISPLAY_MAX];
+#endif
+
 /**
  * Declare a meta type for a type declared with SCOclassdef();
  * the name of this type seldom needs to be explicitly referenced,
@@ -151,14 +235,40 @@ typedef void (*scoVtinit)(void *o);
 #define _SCOmetatype(Class) \
 typedef struct Class##_Virt { scoDtor dtor; Class##__ } Class##_Virt; \
 typedef struct Class##_Meta { \
-	const struct scoObject_Meta *super; \
-	size_t size; \
-	unsigned short vnum; \
-	unsigned char done; \
-	const char *name; \
-	scoVtinit vtinit; /* virtual table init function, passed meta */ \
+	SCO__META_MEMBERS \
+	Class##_Virt virt; \
+} Class##_Meta; \
+enum { SCO__##Class##_vvoff = 0, SCO__##Class##_vvsize = 0 }
+
+/**
+ * Declare a meta type with virtual variables (see \ref sco_vvar()) for
+ * a type declared with SCOvvclassdef(). This is otherwise the same as
+ * \ref _SCOmetatype(), and \ref SCOvvmetatype() is the version which
+ * also forward-declares the global meta type instance.
+ *
+ * The declaration uses a third macro, named the same as the class except
+ * for having \a three appended underscores, which lists the virtual
+ * variables of the class as ordinary struct members. Like the list of
+ * virtual methods, it must begin by referencing that of the superclass,
+ * if any. The variables form a struct named the same as the class except
+ * with _Vars appended, kept after the virtual table in the meta type.
+ * The list must not be empty, and once a class has virtual variables,
+ * so must its subclasses, which is checked on initialization.
+ *
+ * _SCOvvclassdef() combines this and SCOclasstype() into a single step.
+ */
+#define _SCOvvmetatype(Class) \
+typedef struct Class##_Virt { scoDtor dtor; Class##__ } Class##_Virt; \
+typedef struct Class##_Vars { Class##___ } Class##_Vars; \
+typedef struct Class##_Meta { \
+	SCO__META_MEMBERS \
 	Class##_Virt virt; \
-} Class##_Meta
+	Class##_Vars vars; \
+} Class##_Meta; \
+enum { \
+	SCO__##Class##_vvoff = offsetof(struct Class##_Meta, vars), \
+	SCO__##Class##_vvsize = sizeof(Class##_Vars) \
+}
 
 /** Declare a meta type for a type declared with SCOclassdef().
   * the name of this type seldom needs to be explicitly referenced,
@@ -185,6 +295,16 @@ typedef struct Class##_Meta { \
 _SCOmetatype(Class); \
 SCO_USERAPI extern Class##_Meta _##Class##_meta
 
+/** Declare a meta type with virtual variables, like _SCOvvmetatype(),
+  * and forward-declare the global meta type instance for symbol export,
+  * like SCOmetatype().
+  *
+  * SCOvvclassdef() combines this and SCOclasstype() into a single step.
+  */
+#define SCOvvmetatype(Class) \
+_SCOvvmetatype(Class); \
+SCO_USERAPI extern Class##_Meta _##Class##_meta
+
 /** Get the global meta type instance of the \p Class named.
   *
   * This requires it to have been either forward-declared with
@@ -217,6 +337,22 @@ _SCOmetatype(Class)
 SCOclasstype(Class); \
 SCOmetatype(Class)
 
+/** This combines SCOclasstype() and _SCOvvmetatype() to declare a class
+  * with virtual variables and its meta type at once.
+  * \see _SCOclassdef()
+  */
+#define _SCOvvclassdef(Class) \
+SCOclasstype(Class); \
+_SCOvvmetatype(Class)
+
+/** This combines SCOclasstype() and SCOvvmetatype() to declare a class
+  * with virtual variables and its meta type at once, for a public API.
+  * \see SCOclassdef()
+  */
+#define SCOvvclassdef(Class) \
+SCOclasstype(Class); \
+SCOvvmetatype(Class)
+
 /** Use to declare a pair of allocation and constructor functions for a
   * class if they do not take variable arguments. This version is used
   * to forward-declare a static pair (not part of any visible API).
@@ -244,6 +380,17 @@ static inline unsigned char FunctionName##_ctor##NameSuffix Parlist
 SCO_USERAPI Class* FunctionName##_new##NameSuffix Parlist; \
 SCO_USERAPI unsigned char FunctionName##_ctor##NameSuffix Parlist
 
+#if defined(SCO_STATS) && !defined(SCO_DOXYGEN)
+/* times constructor calls in *_new() functions, see scoop/Stats.h */
+# define SCO__CTOR_TIMER unsigned long long SCOctordef__t;
+# define SCO__CTOR_CALL(Class, call) \
+	(SCOctordef__t = sco_stats_now(), \
+	 sco_stats_ctor_done(sco_metaof(Class), SCOctordef__t, (call)))
+#else
+# define SCO__CTOR_TIMER
+# define SCO__CTOR_CALL(Class, call) (call)
+#endif
+
 /** Use to define a pair of allocation and constructor functions for a
   * class if they do not take variable arguments. This version is used
   * to for a static pair (not part of any visible API).
@@ -255,11 +402,11 @@ static inline unsigned char FunctionName##_ctor##NameSuffix Parlist; \
 static Class* FunctionName##_new##NameSuffix Parlist \
 { \
 	void *SCOctordef__mem = (SCO_ARG1 Arglist); \
+	SCO__CTOR_TIMER \
 	if (((SCO_ARG1 Arglist) = \
 	     sco_raw_new(SCOctordef__mem, sco_metaof(Class))) != NULL && \
-	    !FunctionName##_ctor##NameSuffix Arglist) { \
-		sco_set_metaof((SCO_ARG1 Arglist), scoNone); \
-		if (!SCOctordef__mem) free((SCO_ARG1 Arglist)); \
+	    !SCO__CTOR_CALL(Class, FunctionName##_ctor##NameSuffix Arglist)) { \
+		sco_raw_delete((SCO_ARG1 Arglist), SCOctordef__mem); \
 		return 0; \
 	} \
 	return (SCO_ARG1 Arglist); \
@@ -276,11 +423,14 @@ static inline unsigned char FunctionName##_ctor##NameSuffix Parlist
   * named, must come first in \p Arglist.
   *
   * The FunctionName_new() function will first allocate zero'd
-  * memory if its memory pointer argument is zero, otherwise zero and
+  * memory (from the class's pool if it has one, see \ref SCO_POOL)
+  * if its memory pointer argument is zero, otherwise zero and
   * (re)use memory. If allocation is successful, it will thereafter set
   * the meta type, and then call the corresponding
   * FunctionName_ctor() function. If everything succeeds, the address of
   * the instance is returned, otherwise NULL is returned.
+  * If SCO_STATS is defined, the time taken by the constructor is counted
+  * for the class (see scoop/Stats.h).
   *
   * The FunctionName_ctor() function is a constructor which takes a
   * valid memory block - zero'd and with the correct meta type
@@ -309,11 +459,11 @@ unsigned char FunctionName##_ctor##NameSuffix Parlist; \
 Class* FunctionName##_new##NameSuffix Parlist \
 { \
 	void *SCOctordef__mem = (SCO_ARG1 Arglist); \
+	SCO__CTOR_TIMER \
 	if (((SCO_ARG1 Arglist) = \
 	     sco_raw_new(SCOctordef__mem, sco_metaof(Class))) != NULL && \
-	    !FunctionName##_ctor##NameSuffix Arglist) { \
-		sco_set_metaof((SCO_ARG1 Arglist), scoNone); \
-		if (!SCOctordef__mem) free((SCO_ARG1 Arglist)); \
+	    !SCO__CTOR_CALL(Class, FunctionName##_ctor##NameSuffix Arglist)) { \
+		sco_raw_delete((SCO_ARG1 Arglist), SCOctordef__mem); \
 		return 0; \
 	} \
 	return (SCO_ARG1 Arglist); \
@@ -345,18 +495,145 @@ unsigned char FunctionName##_ctor##NameSuffix Parlist
   * shouldn't) change any other pointers: definitions inherited from the
   * superclass are automatically copied, and "pure virtual" (i.e. as-yet
   * undefined) functions are automatically defined to prompt a fatal error
-  * (using \ref sco_fatal()) if called.
+  * (using \ref sco_fatal()) if called. Virtual variables (see \ref
+  * sco_vvar()) are also copied from the superclass before vtinit is
+  * called, and any others are zero unless set by it. If the class has
+  * members which must be deep-copied by sco_clone(), vtinit should also
+  * set the copy hook of the meta type, and if it implements interfaces,
+  * the list of them (see scoop/Iface.h).
+  *
+  * An optional argument may follow \p vtinit, giving flags for the class
+  * combined using bitwise or. The following flags are available:
+  * - \ref SCO_POOL
+  * - \ref SCO_FINAL
+  * - \ref SCO_TRACK
+  * - \ref SCO_CACHELINE
+  *
+  * The class is also listed when the program starts (or the plugin
+  * defining it is loaded), so that sco_class_load() can find it by name
+  * before it is initialized.
   */
-#define SCOmetainst(Class, Superclass, dtor, vtinit) \
+#define SCOmetainst(Class, Superclass, dtor, ... /* vtinit, flags */) \
 struct Class##_Meta _##Class##_meta = { \
 	(scoObject_Meta*)sco_metaof(Superclass), \
 	sizeof(Class), \
+	__alignof__(Class), \
 	(sizeof(Class##_Virt) / sizeof(void (*)())), \
+	SCO__##Class##_vvoff, \
+	SCO__##Class##_vvsize, \
+	0, \
+	SCO_ARG1(SCO_ARGS_TAIL(__VA_ARGS__) \
+		SCO_COMMA_ON_ARGS(SCO_ARGS_TAIL(__VA_ARGS__)) 0), \
+	0, \
 	0, \
 	#Class, \
-	(scoVtinit)vtinit, \
+	(scoVtinit)SCO_ARG1(__VA_ARGS__), \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	{0}, \
 	{(scoDtor)dtor}, \
-}
+}; \
+static void SCO__##Class##_declare(void) __attribute__((constructor)); \
+static void SCO__##Class##_declare(void) \
+{ \
+	static scoClassDecl decl = {&_##Class##_meta, 0}; \
+	sco_class_declare(&decl); \
+} \
+extern struct Class##_Meta _##Class##_meta
+
+/** Class flag for SCOmetainst(): allocate instances from a slab pool.
+  *
+  * Instead of using calloc() and free(), sco_raw_new() will then take
+  * memory for new instances from a free list of pre-zeroed slots, and
+  * sco_delete() will return the memory to it. Slots are carved out of
+  * larger slabs, allocated as needed and kept for reuse. The pool is
+  * per class (subclasses are not pooled unless flagged themselves), so
+  * its slots are all of the class's size.
+  *
+  * Each thread keeps a cache of free slots for the pool, in two
+  * magazines of 32 slots, so that creating and deleting instances
+  * usually takes no lock and touches no memory shared with other
+  * threads. Full and empty magazines are exchanged with the pool in one
+  * go, so that slots freed by one thread are handed in batches to
+  * another which creates instances. A thread's magazines are emptied
+  * into the pool when it exits.
+  *
+  * \see sco_pool_enable() for enabling a pool using a function call.
+  * \see sco_pool_stats() for statistics on pool use.
+  */
+#define SCO_POOL 0x0001
+
+/** Class flag for SCOmetainst(): the class is final, i.e. may not have
+  * subclasses. Defining a subclass for it is a fatal error, reported
+  * when the subclass is initialized.
+  *
+  * Methods of a final class can be called using \ref sco_fvirt(),
+  * which takes them from the meta type of the class rather than through
+  * the meta type pointer of the instance.
+  */
+#define SCO_FINAL 0x0002
+
+/** Class flag for SCOmetainst(): keep a list of the live instances of
+  * the class, so that they can all be destroyed using sco_clean().
+  * Subclasses of the class are tracked too, each in a list of its own.
+  *
+  * The list is intrusive, linking instances through a scoTrackLink
+  * member which must come right after the meta type pointer; the base
+  * class of the hierarchy should begin its member list with
+  * \ref scoTracked_. Linking and unlinking instances costs a few
+  * pointer updates under a per-class lock, done by sco_raw_new(),
+  * sco_raw_delete(), sco_delete() and sco_finalize().
+  */
+#define SCO_TRACK 0x0004
+
+/** The size of a cache line assumed for \ref SCO_CACHELINE. */
+#define SCO_CACHE_LINE 64
+
+/** Class flag for SCOmetainst(): align instances to cache lines, and
+  * pad them to whole cache lines, so that no two instances (or other
+  * data) share a cache line, e.g. for objects updated by different
+  * threads.
+  *
+  * Instances are otherwise aligned as their struct type requires, which
+  * may be more than malloc() gives, e.g. for members declared with the
+  * aligned attribute. sco_raw_new(), sco_clone(), pools (see
+  * \ref SCO_POOL) and arenas (see scoop/Arena.h) all allocate memory
+  * aligned and padded accordingly; memory given to sco_raw_new() must
+  * be aligned by the caller. The alignment used is kept in the \a align
+  * field of the meta type. The flag is inherited by subclasses.
+  */
+#define SCO_CACHELINE 0x0010
+
+/** Class flag set when a class is initialized, if neither it nor any
+  * superclass has a destructor. (It is not to be given to SCOmetainst().)
+  * Destroying an instance then runs no code, and arrays of instances
+  * can be freed in bulk using sco_delete_n().
+  */
+#define SCO_TRIVIAL 0x8000
+
+/** Class flag set when a class is initialized, if it or a superclass
+  * has a copy hook. (It is not to be given to SCOmetainst().) Otherwise,
+  * sco_clone() makes a plain bitwise copy.
+  */
+#define SCO_COPYHOOK 0x4000
+
+/** Link in the list of instances of a class, see \ref SCO_TRACK.
+  */
+typedef struct scoTrackLink {
+	struct scoTrackLink *prev, *next;
+} scoTrackLink;
+
+/** Member list to begin the member list of a base class with, if
+  * the class or a subclass of it is to be flagged \ref SCO_TRACK.
+  */
+#define scoTracked_ scoTrackLink sco_track;
 
 /** The member content list for the dummy type scoObject - it is empty,
   * and does not need to be referenced anywhere.
@@ -424,9 +701,46 @@ _SCOmetatype(scoObject);
   * dynamically selected versions of functions. When the
   * function doesn't take an object pointer as its first
   * argument, \ref sco_svirt() can instead be used.
+  *
+  * If SCO_TRACE is defined, calls are counted and sampled,
+  * see scoop/Trace.h.
   */
-#define sco_virt(func, ...) \
+#if defined(SCO_TRACE) && !defined(SCO_DOXYGEN)
+/* counts and samples traced calls, see scoop/Trace.h */
+# define SCO__TRACE(o, func, call) ({ \
+	__attribute__((cleanup(sco_trace_end))) scoTraceSpan SCO__span = \
+		sco_trace_begin((o)->meta, (unsigned int) \
+			(((const char*)&(o)->meta->virt.func - \
+			  (const char*)&(o)->meta->virt) / \
+			 sizeof(void (*)())), #func); \
+	call; })
+# define sco_virt(func, ...) \
+	SCO__TRACE(SCO_ARG1(__VA_ARGS__), func, \
+		(SCO_ARG1(__VA_ARGS__))->meta->virt.func(__VA_ARGS__))
+#else
+# define sco_virt(func, ...) \
 	(SCO_ARG1(__VA_ARGS__))->meta->virt.func(__VA_ARGS__)
+#endif
+
+/** Get the virtual variable named \p name of the class of the instance
+  * \p o. This is a per-class value, stored in the meta type rather than
+  * in each instance, which costs one load from the meta type pointer.
+  *
+  * Virtual variables are declared in the virtual variable list of a
+  * class declared using SCOvvclassdef() (see \ref _SCOvvmetatype()), as
+  * ordinary struct members, e.g.:
+  *
+  *     #define Node___ \
+  *       unsigned int type_code; \
+  *       const struct Table *table;
+  *     SCOvvclassdef(Node);
+  *
+  * Like virtual methods, they are inherited by subclasses, and set or
+  * overridden by the vtinit function of a class (see SCOmetainst()),
+  * as in o->vars.type_code = 3. Those not set are zero.
+  */
+#define sco_vvar(name, o) \
+	((o)->meta->vars.name)
 
 /** Call a static virtual method named \p func belonging to the
   * class instance given by the second argument. Only arguments
@@ -436,8 +750,107 @@ _SCOmetatype(scoObject);
   * take the object pointer as their first parameter. Otherwise
   * it is the same as \ref sco_virt().
   */
-#define sco_svirt(func, ...) \
+#if defined(SCO_TRACE) && !defined(SCO_DOXYGEN)
+# define sco_svirt(func, ...) \
+	SCO__TRACE(SCO_ARG1(__VA_ARGS__), func, \
+		(SCO_ARG1(__VA_ARGS__))->meta->virt.func( \
+			SCO_ARGS_TAIL(__VA_ARGS__)))
+#else
+# define sco_svirt(func, ...) \
 	(SCO_ARG1(__VA_ARGS__))->meta->virt.func(SCO_ARGS_TAIL(__VA_ARGS__))
+#endif
+
+/** Call a virtual method named \p func for an instance of the final
+  * \p Class (see \ref SCO_FINAL) given by the third argument, passing
+  * the instance, and any additional arguments after it.
+  *
+  * Since a final class has no subclasses, the version of the function
+  * to call is known from the class, and this convenience macro takes it
+  * from the global meta type instance of \p Class rather than through
+  * the \a meta pointer of the instance. The call then does not depend
+  * on loading the instance first, and a function pointer loaded from the
+  * same place in a loop may be kept in a register.
+  *
+  * If SCO_DEBUG is defined, it is checked that \p Class is final, and
+  * that the instance has its meta type.
+  */
+#if defined(SCO_DEBUG) || defined(SCO_DOXYGEN)
+# define sco_fvirt(Class, func, ...) \
+	((void)((sco_metaof(Class)->flags & SCO_FINAL) || \
+	 (sco_fatal("Error: sco_fvirt() for " #Class ", not final"), 0)), \
+	 (void)((SCO_ARG1(__VA_ARGS__))->meta == sco_metaof(Class) || \
+	 (sco_fatal("Error: sco_fvirt() for " #Class " given other class"), \
+	  0)), \
+	 sco_metaof(Class)->virt.func(__VA_ARGS__))
+#else
+# define sco_fvirt(Class, func, ...) \
+	sco_metaof(Class)->virt.func(__VA_ARGS__)
+#endif
+
+/** Reorders an array of \p n object pointers at \p objs so that objects
+  * of the same class follow each other. Groups are ordered by the first
+  * appearance of each class, and within a group, objects keep their
+  * relative order. Arrays which are already grouped are left as they are,
+  * after a single pass over the array.
+  *
+  * This is used by \ref sco_virt_batch() and \ref sco_virt_bulk().
+  */
+SCO_API void sco_group_by_meta(void *objs, size_t n);
+
+/** Call a virtual method named \p func for each object in an array,
+  * given as the second argument. The third argument is the number of
+  * objects, and any further arguments are passed after the object in
+  * each call.
+  *
+  * The array is first reordered using \ref sco_group_by_meta(), so that
+  * the calls are made a class at a time. Each run of calls then reaches
+  * the same function through the same pointer, which an indirect branch
+  * predictor handles well even when classes were interleaved in the array.
+  *
+  * This convenience macro is a statement, not an expression.
+  */
+#define sco_virt_batch(func, objs, ...) do{ \
+	size_t SCO__i = 0, SCO__j, SCO__n = SCO_ARG1(__VA_ARGS__); \
+	sco_group_by_meta((objs), SCO__n); \
+	while (SCO__i < SCO__n) { \
+		SCO__j = SCO__i; \
+		do { \
+			(objs)[SCO__i]->meta->virt.func \
+				SCO_SUBST_HEAD((objs)[SCO__j], (__VA_ARGS__)); \
+		} while (++SCO__j < SCO__n && \
+		         (objs)[SCO__j]->meta == (objs)[SCO__i]->meta); \
+		SCO__i = SCO__j; \
+	} \
+}while(0)
+
+/** Like \ref sco_virt_batch(), but the virtual method named \p func is
+  * called only once per run of objects of the same class, being passed
+  * the address of the first object pointer in the run and the number of
+  * objects in it, followed by any further arguments. It should thus have
+  * a signature like:
+  *
+  *     void (*func)(SCO_TYPE *const *objs, size_t n, ...);
+  *
+  * A base class can define a version which loops over the objects making
+  * ordinary virtual calls, while subclasses define versions handling the
+  * whole run more efficiently.
+  *
+  * This convenience macro is a statement, not an expression.
+  */
+#define sco_virt_bulk(func, objs, ...) do{ \
+	size_t SCO__i = 0, SCO__j, SCO__n = SCO_ARG1(__VA_ARGS__); \
+	sco_group_by_meta((objs), SCO__n); \
+	while (SCO__i < SCO__n) { \
+		SCO__j = SCO__i; \
+		while (++SCO__j < SCO__n && \
+		       (objs)[SCO__j]->meta == (objs)[SCO__i]->meta) ; \
+		(objs)[SCO__i]->meta->virt.func((void*)&(objs)[SCO__i], \
+			SCO__j - SCO__i \
+			SCO_COMMA_ON_ARGS(SCO_ARGS_TAIL(__VA_ARGS__)) \
+			SCO_ARGS_TAIL(__VA_ARGS__)); \
+		SCO__i = SCO__j; \
+	} \
+}while(0)
 
 /** Allocation method used in instance construction functions,
   * typically in the wrapper around the initialization
@@ -450,27 +863,197 @@ _SCOmetatype(scoObject);
   * it.
   *
   * If not done, the final run-time initialization of the type
-  * description will be performed.
+  * description will be performed. Once that has happened, checking
+  * for it only costs a single (acquire) load of the meta type state.
   *
   * The \a meta pointer of the new object is set to \p
   * meta.
   */
 SCO_API void* sco_raw_new(void *mem, void *meta);
 
+/** Performs the run-time initialization of the meta type \p meta, and
+  * of its superclasses, if not done; sco_raw_new() otherwise does this
+  * when the first instance is created. The class is then registered.
+  */
+SCO_API void sco_meta_init(void *meta);
+
+/** Entry in the list of classes defined in the program, for finding a
+  * class by name before it is initialized (see sco_class_load()).
+  */
+typedef struct scoClassDecl {
+	void *meta;
+	struct scoClassDecl *next;
+} scoClassDecl;
+
+/** Adds \p decl to the list of classes defined. Called for each class
+  * at program start, or on loading a plugin, by SCOmetainst().
+  */
+SCO_API void sco_class_declare(scoClassDecl *decl);
+
+/** Record of a traced virtual call in progress, used by sco_virt() and
+  * sco_svirt() when SCO_TRACE is defined. See scoop/Trace.h.
+  */
+typedef struct scoTraceSpan {
+	struct scoTraceEntry *entry; /* NULL unless timed */
+	unsigned long long start;
+} scoTraceSpan;
+
+/** Counts a call of virtual slot number \p slot, named \p name, for the
+  * class given by \p meta, and starts timing it if sampled.
+  */
+SCO_API scoTraceSpan sco_trace_begin(const void *meta, unsigned int slot,
+		const char *name);
+
+/** Ends a call counted by sco_trace_begin(). */
+SCO_API void sco_trace_end(scoTraceSpan *span);
+
+/** Returns a monotonic time in nanoseconds, if the library was built
+  * with SCO_STATS defined, otherwise zero. See scoop/Stats.h.
+  */
+SCO_API unsigned long long sco_stats_now(void);
+
+/** Adds the time since \p start to the constructor time counted for the
+  * class given by \p meta, and returns \p ok. Called by the *_new()
+  * functions defined using SCOctordef() when SCO_STATS is defined.
+  */
+SCO_API unsigned char sco_stats_ctor_done(const void *meta,
+		unsigned long long start, unsigned char ok);
+
+/** Counterpart of sco_raw_new() for use when construction failed,
+  * undoing it without calling any destructors. \p mem should be what
+  * was passed to sco_raw_new(); if zero, the allocation is released,
+  * otherwise the \a meta pointer of \p o is zeroed.
+  */
+SCO_API void sco_raw_delete(void *o, void *mem);
+
 /** Destroys object and frees memory, first calling every destructor in
   * the class hierarchy from present type to base type.
+  *
+  * The memory is returned to the class's pool if it has one (see
+  * \ref SCO_POOL); otherwise it is freed as allocated by sco_raw_new().
   */
 SCO_API void sco_delete(void *o);
 
+/** Destroys the \p n objects in the array of object pointers at \p objs
+  * and frees their memory, like sco_delete() for each. Runs of objects
+  * of the same trivially destructible class (see \ref SCO_TRIVIAL) are
+  * freed without a call per object. For a class with a pool (see
+  * \ref SCO_POOL), a run fills the magazines of the calling thread, and
+  * the rest of it is handed to the pool under a single lock, in full
+  * magazines as far as the pool has empty ones to fill.
+  */
+SCO_API void sco_delete_n(void *objs, size_t n);
+
 /** Destroys object without freeing memory, calling every destructor in
   * the class hierarchy from present type to base type, and then zeroes
   * the type pointer so that the object is left explicitly invalid.
   *
-  * The allocation can then be reused - and/or, if dynamic, later freed
-  * with free().
+  * The allocation can then be reused. Dynamic memory from sco_raw_new()
+  * must not be freed with free(), as it may be a slot in the class's
+  * pool or be allocated over-aligned; to free it, use sco_delete()
+  * instead of this, or sco_raw_delete() to undo sco_raw_new() when no
+  * construction was done.
   */
 SCO_API void sco_finalize(void *o);
 
+/** Creates a copy of object \p o. The copy is allocated as by
+  * sco_raw_new() if \p mem is NULL, otherwise \p mem is used.
+  *
+  * The object is first copied bitwise, and then the copy hooks of its
+  * class and superclasses are called on the copy, base class first,
+  * given the copy and \p o. (A copy hook is set by vtinit, see
+  * SCOmetainst(), and needed only for members which must be deep-copied.)
+  * If a copy hook fails, it must undo its own work; the destructors of
+  * the superclasses, whose hooks succeeded, are then called.
+  *
+  * Returns the copy, or NULL if memory allocation or a copy hook failed.
+  */
+SCO_API void *sco_clone(const void *o, void *mem);
+
+/** Makes \p n copies of object \p o, as with sco_clone(), placed one
+  * after another in the array at \p mem (of the object's class, i.e.
+  * spaced at its size). Without copy hooks (see \ref SCO_COPYHOOK),
+  * this is a plain bitwise copy in one pass.
+  *
+  * Returns the number of copies made, less than \p n only if a copy
+  * hook failed; the copies made are then valid objects.
+  */
+SCO_API size_t sco_clone_n(const void *o, void *mem, size_t n);
+
+/** Destroys all tracked instances of the class given by \p meta (see
+  * \ref SCO_TRACK), and then those of each of its subclasses, in the
+  * order they were created for each class. Each instance is removed from
+  * the list and passed to \p destroy, which should be sco_delete() for
+  * instances allocated by sco_raw_new(), or sco_finalize() (used if
+  * \p destroy is NULL) for instances in memory managed otherwise.
+  *
+  * Instances created while cleaning are also destroyed. Does nothing
+  * unless the class is tracked and has been initialized.
+  */
+SCO_API void sco_clean(void *meta, void (*destroy)(void *o));
+
+/** Removes \p o from the list of instances of its class, if tracked
+  * (see \ref SCO_TRACK), so that sco_clean() will leave it alone.
+  */
+SCO_API void sco_untrack(void *o);
+
+/** Statistics on the slab pool of a class, see \ref SCO_POOL.
+  * The occupancy of the pool is \a used out of \a slots, with \a cached
+  * more free slots held in magazines. Those are counted as used in the
+  * \a peak. The counts of caches are read as other threads update them,
+  * so that they are not from a single instant.
+  */
+typedef struct scoPoolStats {
+	size_t slot_size; /* size of each slot, in bytes */
+	size_t slab_slots; /* number of slots per slab */
+	size_t slabs; /* number of slabs allocated */
+	size_t slots; /* number of slots in all slabs */
+	size_t used; /* number of slots currently in use */
+	size_t cached; /* number of free slots in magazines */
+	size_t peak; /* highest number of slots in use or cached at once */
+	size_t allocs; /* number of times a slot was taken into use */
+} scoPoolStats;
+
+/** Enables the slab pool for a class given its meta type, like
+  * the \ref SCO_POOL flag, but with \p slab_slots slots per slab.
+  * If \p slab_slots is zero, a default based on the size is used.
+  *
+  * This must be done before the first instance of the class is created.
+  * If the pool was already enabled, only its slab size is changed.
+  *
+  * Returns non-zero on success, zero on failure (if the class already
+  * has instances, or memory allocation failed).
+  */
+SCO_API int sco_pool_enable(void *meta, size_t slab_slots);
+
+/** Gets statistics on the slab pool for a class given its meta type.
+  *
+  * Returns non-zero and sets \p stats if the class has a pool,
+  * otherwise returns zero.
+  */
+SCO_API int sco_pool_stats(const void *meta, scoPoolStats *stats);
+
+/** Enables prototype construction for a class given its meta type.
+  * When the class is initialized, a prototype instance is made and
+  * passed to \p ctor, a default constructor which (unlike the class's
+  * *_new() functions) takes no other arguments. sco_raw_new() then
+  * copies the prototype into new instances, instead of zeroing them,
+  * so that the constructors used with it need only do per-instance work.
+  * (Memory in a pool, see \ref SCO_POOL, is then not zeroed either.)
+  *
+  * Each copy is a plain bitwise one, so \p ctor should only set plain
+  * values, not allocate memory or objects owned by the instance. It is
+  * called once, on first use of the class, and must not create instances
+  * of the class. If it fails, the class warns and zeroes instances.
+  *
+  * This must be done before the first instance of the class is created.
+  * It is per class; subclasses only get a prototype if enabled for them.
+  *
+  * Returns non-zero on success, zero on failure (if the class already
+  * has instances, or memory allocation failed).
+  */
+SCO_API int sco_proto_enable(void *meta, scoCtor ctor);
+
 /** An underlying function used by the more convenient class type-checking
   * macros:
   * - sco_subclass()
@@ -480,6 +1063,14 @@ SCO_API void sco_finalize(void *o);
   *
   * It checks if \p submeta is a subclass of \p meta.
   * Returns 1 if subclass, 0 if same class, -1 if neither.
+  *
+  * The check is made by looking up the superclass at the depth of
+  * \p meta in the display of superclasses of \p submeta, so it takes
+  * constant time regardless of the depth of the class hierarchy
+  * (as long as \p meta is less than \ref SCO_DISPLAY_MAX levels deep).
+  * Classes are not initialized by the check; until \p submeta is, the
+  * check walks up its superclass chain instead. Every class counts as
+  * a subclass of \a scoNone (a NULL \p meta).
   */
 SCO_API int sco_rtticheck(const void *submeta, const void *meta);
 
@@ -0,0 +1,113 @@
+/* SCOOP Parallel module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Parallel_h
+#define scoop_Parallel_h
+#include "Object.h"
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Parallel calls of a virtual method for each object in an array, made
+   by a pool of threads, for when the calls are independent of each
+   other.
+
+   sco_parallel_virt() splits the array into one range per thread, the
+   calling thread taking part, and returns once all calls have been made.
+   Each thread works through its range in chunks of a given number of
+   objects (the grain size), and a thread which runs out of work steals
+   the back half of what remains in another's range. Uneven costs per
+   object are thus evened out, while threads mostly work on their own
+   contiguous part of the array.
+
+   The method must have the form
+
+       void (*func)(void *o, void *arg);
+
+   (see \ref scoParallelFunc), and is given the same \p arg for each
+   object. It may run in any thread, and in any order between objects.
+
+   With \ref SCO_PARALLEL_GROUP, each chunk is reordered using
+   \ref sco_group_by_meta() before the calls, as for sco_virt_batch().
+ */
+
+/** Function pointer type of methods called by sco_parallel_virt(). */
+typedef void (*scoParallelFunc)(void *o, void *arg);
+
+/** A pool of threads making parallel calls. */
+typedef struct scoParallel scoParallel;
+
+/** Flag for sco_parallel_virt(): reorder the objects of each chunk so
+  * that those of the same class are called one after the other. Objects
+  * are only moved within chunks, but may end up in another order there.
+  */
+#define SCO_PARALLEL_GROUP (1<<0)
+
+/** Creates a pool for making calls in \p threads threads, counting the
+  * thread calling sco_parallel_virt(), or in one per CPU if zero. The
+  * pool thus starts one thread less than the number.
+  *
+  * Returns the pool, or NULL if memory allocation or thread creation
+  * failed.
+  */
+SCO_API scoParallel *sco_parallel_create(unsigned int threads);
+
+/** Stops and joins the threads and frees the pool. It must not be in
+  * use.
+  */
+SCO_API void sco_parallel_destroy(scoParallel *o);
+
+/** Call the virtual method named \p func for each of the \p n objects
+  * in the array \p objs, passing \p arg after the object, using the
+  * threads of \p pool, and wait for all calls to finish.
+  *
+  * \p grain is the number of objects a thread takes at a time, or zero
+  * to use a fraction of what each thread is first given. \p flags may
+  * be \ref SCO_PARALLEL_GROUP, or zero.
+  *
+  * If \p pool is NULL, or busy with another call (e.g. one from a method
+  * called by it), or there is no more than one grain of objects, the
+  * calling thread makes all calls itself.
+  *
+  * This convenience macro is a statement, not an expression.
+  */
+#define sco_parallel_virt(pool, func, objs, n, grain, flags, arg) do{ \
+	(void)sizeof((objs)[0]->meta->virt.func == (scoParallelFunc)0); \
+	sco_parallel_apply((pool), (objs), (n), (grain), (flags), \
+		(offsetof(__typeof__(*(objs)[0]->meta), virt.func) - \
+		 offsetof(__typeof__(*(objs)[0]->meta), virt)) / \
+		sizeof(void (*)()), (arg)); \
+}while(0)
+
+/** Calls the method in slot \p slot of the virtual table of each object,
+  * otherwise as described for sco_parallel_virt(), which uses this.
+  */
+SCO_API void sco_parallel_apply(scoParallel *pool, void *objs, size_t n,
+		size_t grain, int flags, size_t slot, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,98 @@
+/* SCOOP Ref module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_Ref_h
+#define scoop_Ref_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Reference-counted objects, for sharing instances between threads
+   without each retain and release being an atomic operation.
+
+   A class which derives from scoRef (listing scoRef_ first in its member
+   list, and scoRef__ first in its virtual list) gets a reference count,
+   set to one by its constructor, sco_Ref_ctor(), which the constructors
+   of subclasses must call. sco_retain() adds a reference and
+   sco_release() removes one, calling sco_delete() on the object when the
+   last one is gone.
+
+   The count is biased towards the thread which created the object, its
+   owner. References taken and dropped by the owner are counted in a plain
+   counter, which only the owner touches; those of other threads are
+   counted in a second, atomic one. When the owner drops its last
+   reference, the two counts are merged, and the object is then counted
+   only atomically. When another thread drops more references than it
+   took, it hands the object over to the owner for an early merge, which
+   the owner makes the next time it calls sco_release() (or
+   sco_ref_collect()). Once an owner has exited, an object handed over
+   to it is instead merged by the thread handing it over.
+
+   Instances must be allocated by the library (created using a *_new()
+   function without a memory argument, or sco_clone()), as sco_delete()
+   frees them. Copies made by sco_clone() are owned by the copying thread
+   and start with one reference.
+ */
+
+/** The member list of scoRef. The members are private. */
+#define scoRef_ \
+	struct scoRefOwner *ref_owner; /* owning thread, if not merged */ \
+	unsigned int ref_local; /* references counted by the owner */ \
+	int ref_shared; /* by other threads, times 4, and merge flags */ \
+	struct scoRef *ref_next; /* in queue for merging by the owner */
+
+/** The virtual method list of scoRef, which is empty. */
+#define scoRef__
+
+SCOclassdef(scoRef);
+
+/** Constructs a reference-counted object with one reference, owned by
+  * the calling thread. Always succeeds. */
+SCOctordec(scoRef, sco_Ref,, (scoRef *o));
+
+/** Adds a reference to the reference-counted object \p o.
+  *
+  * Returns \p o.
+  */
+SCO_API void *sco_retain(void *o);
+
+/** Removes a reference from the reference-counted object \p o, deleting
+  * it using sco_delete() if it was the last one. If \p o is NULL,
+  * nothing is done.
+  */
+SCO_API void sco_release(void *o);
+
+/** Merges the counts of the objects owned by the calling thread which
+  * other threads have handed over, deleting those no longer referenced.
+  * sco_release() does this as needed when called by the owner; a thread
+  * which owns objects but seldom releases any may call it at times, so
+  * that the objects are not kept alive longer than needed.
+  */
+SCO_API void sco_ref_collect(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,87 @@
+/* SCOOP Registry module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef scoop_Registry_h
+#define scoop_Registry_h
+#include "Object.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Registry of all initialized classes, for finding a class by name or
+   by number, and for listing them.
+
+   A class joins the registry when its meta type is initialized, which
+   happens when the first instance is created, or earlier on calling
+   sco_meta_init() (e.g. when loading a plugin, for each class in it).
+   It is given the next class number, starting at 1, which is kept in the
+   \a id field of the meta type.
+
+   Lookups take no lock, and cost a hash of the name and usually a single
+   string comparison. If several classes have the same name, lookup by
+   name finds the first one registered.
+ */
+
+/** Finds the registered class named \p name.
+  *
+  * Returns its meta type, or NULL if there is none.
+  */
+SCO_API void *sco_class_find(const char *name);
+
+/** Finds the class named \p name like sco_class_find(), or if it is not
+  * registered, among the classes defined in the program (and in plugins
+  * loaded) using SCOmetainst(); a class found there is initialized, and
+  * so registered, first.
+  *
+  * Returns its meta type, or NULL if there is none.
+  */
+SCO_API void *sco_class_load(const char *name);
+
+/** Gets the registered class numbered \p id.
+  *
+  * Returns its meta type, or NULL if there is none.
+  */
+SCO_API void *sco_class_get(unsigned int id);
+
+/** Returns the number of registered classes, which are numbered from
+  * 1 up to and including it.
+  */
+SCO_API unsigned int sco_class_count(void);
+
+/** Calls \p func with the meta type of each registered class, in the
+  * order registered, passing \p arg along.
+  */
+SCO_API void sco_class_walk(void (*func)(void *meta, void *arg), void *arg);
+
+/*
+ * Used by the Object module.
+ */
+
+SCO_API int sco_registry_add(void *meta);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
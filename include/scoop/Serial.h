@@ -0,0 +1,135 @@
+/* SCOOP Serial module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef scoop_Serial_h
+#define scoop_Serial_h
+#include "Object.h"
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Binary serialization of graphs of SCOOP objects, written to and read
+   from a stream in a single pass.
+
+   Starting from a list of root objects, every object reachable through
+   object pointer members is written once, numbered in the order written.
+   Each object is written as the number of its class, defined by name the
+   first time the class is used in the stream, followed by its members.
+   Object pointers are written as the numbers of the objects pointed to,
+   or zero for NULL, so that shared objects and cycles are preserved.
+
+   Which members are written is given by the field tables of the classes
+   (see scoField), set in the meta type by vtinit (see SCOmetainst()).
+   The tables of a class and its superclasses are used, base class first;
+   each describes the members added by its class. If no class of an
+   object has a table, all of its members are written as plain data, so
+   its class must then have no pointer members. Plain data is written in
+   the byte order and layout of the machine, and integers of the stream
+   format as variable-length numbers.
+
+   When reading, the classes named in the stream are looked up among
+   those given, or among all classes in the program (see
+   sco_class_load() in scoop/Registry.h), whether or not initialized
+   yet, and each object is created using sco_raw_new() and then has its
+   members filled in; no constructor is called. Pointers to objects not
+   yet read are chained through the members pointing to them until read,
+   so that reading needs no memory beyond the objects and an array with
+   one entry per object. A memory buffer is read in place, and a stream
+   read in small pieces through a fixed buffer.
+ */
+
+/** Kind of member, for scoField. */
+enum {
+	SCO_FIELD_DATA = 1, /* plain data, copied bytewise */
+	SCO_FIELD_OBJECT /* pointer to SCOOP object, or NULL */
+};
+
+/** Description of a member of a class, in a field table. Tables are
+  * arrays ending with an entry with zero \a kind, and can be written
+  * using SCO_FIELD(), SCO_FIELD_OBJ() and SCO_FIELD_END.
+  */
+typedef struct scoField {
+	unsigned int kind; /* SCO_FIELD_DATA, etc. */
+	size_t offset; /* in bytes, from the start of the instance */
+	size_t size; /* in bytes */
+} scoField;
+
+/** Field table entry for plain data member \p member of \p Class. */
+#define SCO_FIELD(Class, member) \
+	{SCO_FIELD_DATA, offsetof(Class, member), sizeof(((Class*)0)->member)}
+
+/** Field table entry for object pointer member \p member of \p Class. */
+#define SCO_FIELD_OBJ(Class, member) \
+	{SCO_FIELD_OBJECT, offsetof(Class, member), sizeof(void*)}
+
+/** End of a field table. */
+#define SCO_FIELD_END {0, 0, 0}
+
+/** Output function for sco_serialize(), passed \p arg along with the
+  * data. Returns non-zero on success, zero on failure.
+  */
+typedef int (*scoSerialWrite)(void *arg, const void *data, size_t size);
+
+/** Input function for sco_deserialize(), passed \p arg along with the
+  * buffer. Returns the number of bytes read into \p data, at most
+  * \p size, and zero at the end of input or on failure.
+  */
+typedef size_t (*scoSerialRead)(void *arg, void *data, size_t size);
+
+/** Writes the \p n objects in \p roots (some of which may be NULL), and
+  * all objects reachable from them, passing the output to \p write in
+  * pieces of up to a few kilobytes.
+  *
+  * Returns non-zero on success, zero if memory allocation or \p write
+  * failed.
+  */
+SCO_API int sco_serialize(void *const *roots, size_t n,
+		scoSerialWrite write, void *arg);
+
+/** Reads objects written by sco_serialize(), getting the input from
+  * \p read, and stores the \p n roots in \p roots. The classes of the
+  * objects are looked up by name among the \p meta_count meta types in
+  * \p metas, or if \p metas is NULL, using sco_class_load(), which
+  * also finds classes not yet initialized.
+  *
+  * Returns non-zero on success. Returns zero on failure (if memory
+  * allocation or \p read failed, the input was invalid, it had other
+  * than \p n roots, or a class was not found or differed in size);
+  * any objects created are then deleted without calling destructors.
+  */
+SCO_API int sco_deserialize(void **roots, size_t n,
+		scoSerialRead read, void *arg,
+		void *const *metas, size_t meta_count);
+
+/** Like sco_deserialize(), but reads the \p size bytes at \p mem. */
+SCO_API int sco_deserialize_mem(void **roots, size_t n,
+		const void *mem, size_t size,
+		void *const *metas, size_t meta_count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,197 @@
+/* SCOOP SoA (structure of arrays) module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef scoop_SoA_h
+#define scoop_SoA_h
+#include "Object.h"
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Structure-of-arrays containers for SCOOP types, where each member of
+   the type is stored in an array (column) of its own. This suits loops
+   over many instances of one type which only touch a few members, as
+   the data they use is then packed together in memory. For classes,
+   the meta type is stored once for the whole container rather than
+   once per instance.
+
+   Columns are allocated aligned to \ref SCO_SOA_ALIGN bytes, so that
+   loops over them can be vectorized by the compiler.
+
+   The container for a type is declared using \ref SCOsoadef(), which
+   needs the members of the type listed using a macro named as the type
+   with _SOA appended. That macro takes the name of another macro, to be
+   invoked for each member with the type and the name of the member. The
+   member list macro of the type (the one named as the type with _ appended)
+   can then be defined using it, and inheritance works the same way. (The
+   type of an array member must be named by a typedef to be listed.)
+
+       #define scoPoint_SOA(X) X(float, x) X(float, y)
+       #define scoPoint_ SCO_SOA_MEMBERS(scoPoint_SOA)
+       SCOstructdef(scoPoint);
+       SCOsoadef(scoPoint);
+
+       #define scoParticle_SOA(X) scoPoint_SOA(X) X(float, vx) X(float, vy)
+       #define scoParticle_ SCO_SOA_MEMBERS(scoParticle_SOA)
+       #define scoParticle__
+       SCOclassdef(scoParticle);
+       SCOsoadef(scoParticle);
+
+   The columns of a container are then named as the members:
+
+       scoParticle_SoA ps;
+       sco_soa_init(scoParticle, &ps, sco_metaof(scoParticle));
+       ...
+       for (i = 0; i < sco_soa_count(&ps); ++i)
+               ps.x[i] += ps.vx[i];
+
+   A container is not thread-safe.
+ */
+
+/** Alignment of columns in bytes, suitable for any vector instructions. */
+#define SCO_SOA_ALIGN 64
+
+/** Declare a struct member for \p Type and \p name.
+  * For use with member listing macros; see \ref SCO_SOA_MEMBERS().
+  */
+#define SCO_SOA_MEMBER(Type, name) Type name;
+
+/** Declare the struct members listed by \p List, a member listing
+  * macro as used for \ref SCOsoadef(). This can define the member
+  * list macro for use with SCOstructdef() and SCOclassdef().
+  */
+#define SCO_SOA_MEMBERS(List) List(SCO_SOA_MEMBER)
+
+/** Description of a column, for each member of a type. */
+typedef struct scoSoAColumn {
+	size_t size; /* size of member */
+	size_t offset; /* offset of member in the type */
+} scoSoAColumn;
+
+/** Common beginning of all containers, followed by the columns. */
+typedef struct scoSoA {
+	const void *meta; /* meta type shared by instances, NULL if none */
+	size_t count, capacity;
+	const scoSoAColumn *columns;
+	size_t column_count;
+} scoSoA;
+
+#define SCO__SOA_COLUMN(Type, name) Type *name;
+/* used where SCO__SoA_Type names the type, as the member macro is not
+ * passed the name of the type */
+#define SCO__SOA_DESC(Type, name) \
+	{sizeof(Type), offsetof(SCO__SoA_Type, name)},
+
+/** Declare a structure-of-arrays container type for the type \p Name,
+  * named as the type with _SoA appended. A macro listing the members
+  * (as described for the SoA module) must be defined, named as the type
+  * with _SOA appended.
+  *
+  * The container is a struct beginning with a \ref scoSoA named soa, after
+  * which follows a pointer for each member, named as the member and
+  * pointing to its column.
+  */
+#define SCOsoadef(Name) \
+typedef struct Name##_SoA { \
+	scoSoA soa; \
+	Name##_SOA(SCO__SOA_COLUMN) \
+} Name##_SoA; \
+static inline const scoSoAColumn *Name##_SoA_columns(size_t *count) { \
+	typedef Name SCO__SoA_Type; \
+	static const scoSoAColumn columns[] = { \
+		Name##_SOA(SCO__SOA_DESC) \
+	}; \
+	*count = sizeof(columns) / sizeof(scoSoAColumn); \
+	return columns; \
+}
+
+/** Initialize the empty container \p o for the type \p Name,
+  * with \p meta as the meta type for the instances. For a class, use
+  * sco_metaof() for it; for a plain struct type, pass NULL.
+  */
+#define sco_soa_init(Name, o, meta) do { \
+	size_t SCO__count; \
+	const scoSoAColumn *SCO__columns = Name##_SoA_columns(&SCO__count); \
+	sco_soa_setup(&(o)->soa, (meta), SCO__columns, SCO__count); \
+} while (0)
+
+/** Get the number of instances in the container \p o. */
+#define sco_soa_count(o) ((o)->soa.count)
+
+/** Get the column for the member \p name of the container \p o, as a
+  * pointer which the compiler knows to be aligned to SCO_SOA_ALIGN.
+  */
+#if defined(__GNUC__) && !defined(__cplusplus)
+# define sco_soa_column(o, name) \
+	((__typeof__((o)->name)) \
+	 __builtin_assume_aligned((o)->name, SCO_SOA_ALIGN))
+#else
+# define sco_soa_column(o, name) ((o)->name)
+#endif
+
+/** Used by \ref sco_soa_init() to initialize a container. */
+SCO_API void sco_soa_setup(scoSoA *o, const void *meta,
+		const scoSoAColumn *columns, size_t column_count);
+
+/** Frees the columns of the container \p o, leaving it empty. */
+SCO_API void sco_soa_fini(void *o);
+
+/** Makes room for at least \p capacity instances in the container \p o.
+  * Returns non-zero on success, zero if memory allocation failed.
+  */
+SCO_API int sco_soa_reserve(void *o, size_t capacity);
+
+/** Adds a copy of the members of the instance \p obj to the end of
+  * the container \p o. The instance may be a temporary, for it is not
+  * itself kept; for classes, its \a meta pointer is not used.
+  *
+  * Returns the index of the new entry, or (size_t)-1 if memory
+  * allocation failed.
+  */
+SCO_API size_t sco_soa_push(void *o, const void *obj);
+
+/** Removes entry \p i from the container \p o, by moving the last entry
+  * into its place.
+  */
+SCO_API void sco_soa_erase(void *o, size_t i);
+
+/** Copies the members of entry \p i of the container \p o into the
+  * instance \p obj. For classes, the instance is first zeroed and its
+  * meta type set; the result is a valid instance, not constructed anew.
+  * It is a copy, neither counted (see scoop/Stats.h) nor listed (see
+  * \ref SCO_TRACK) as an instance of the class, and is not to be passed
+  * to sco_finalize() or sco_delete().
+  */
+SCO_API void sco_soa_get(const void *o, size_t i, void *obj);
+
+/** Copies the members of the instance \p obj into entry \p i of the
+  * container \p o.
+  */
+SCO_API void sco_soa_set(void *o, size_t i, const void *obj);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,108 @@
+/* SCOOP Stats module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef scoop_Stats_h
+#define scoop_Stats_h
+#include "Object.h"
+#include <stdio.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Per-class instance counters, for finding out how many instances of
+   each class are alive, and how fast they are created and destroyed.
+
+   Counting is compiled in by defining SCO_STATS when building the
+   library (e.g. using "make FEATURES=-DSCO_STATS" after "make clean").
+   Otherwise, nothing is counted and no classes are found by the
+   functions below. Code using the library should then define SCO_STATS
+   too, so that the *_new() functions defined using SCOctordef() also
+   time the constructors they call.
+
+   When counting, each initialized class has counters which are updated
+   by sco_raw_new() (creation), sco_delete() and sco_finalize()
+   (destruction, timing the destructors) and sco_raw_delete() (failed
+   construction). Arena instances are destroyed along with the arena (see
+   scoop/Arena.h), and copies made by sco_soa_get() are not counted.
+   Instances which are never destroyed stay counted as live.
+
+   To keep threads from contending for the counters, each thread updates
+   one of a number of shards of them, kept in separate cache lines. The
+   shards are summed when read, so that the counts read while other
+   threads create and destroy instances are not from a single instant.
+   The peak live count is only an upper bound, the sum of the peaks of
+   each shard (capped by the number of allocations). It is exact when a
+   single thread creates and destroys the instances; when they are
+   destroyed by other threads than those which created them, the peaks
+   of the creating threads' shards keep growing, and the sum can be far
+   above the true peak.
+ */
+
+/** Counts for a class, as summed by sco_stats_get(). */
+typedef struct scoClassStats {
+	const char *name; /* name of the class */
+	const void *meta; /* meta type of the class */
+	size_t size; /* size of an instance, in bytes */
+	size_t live; /* instances created and not yet destroyed */
+	size_t peak; /* upper bound on the highest live count (see above) */
+	size_t allocs; /* instances created, including failed ones */
+	size_t failures; /* constructions which failed */
+	size_t bytes; /* memory taken by live instances, in bytes */
+	unsigned long long ctor_ns; /* total time in constructors */
+	unsigned long long dtor_ns; /* total time in destructors */
+} scoClassStats;
+
+/** Gets the counts for the class given by \p meta.
+  *
+  * Returns non-zero and sets \p stats if the class has counters,
+  * zero if the library was built without SCO_STATS or the class
+  * has not been initialized.
+  */
+SCO_API int sco_stats_get(const void *meta, scoClassStats *stats);
+
+/** Calls \p func with the counts for each initialized class, most
+  * recently initialized first, passing \p arg along.
+  */
+SCO_API void sco_stats_walk(void (*func)(const scoClassStats *stats,
+		void *arg), void *arg);
+
+/** Prints a table of the counts for each initialized class to \p out,
+  * with the average constructor and destructor times in nanoseconds.
+  */
+SCO_API void sco_stats_dump(FILE *out);
+
+/*
+ * Used by the Object module when built with SCO_STATS.
+ */
+
+SCO_API struct scoStats *sco_stats_create(const void *meta);
+SCO_API void sco_stats_new(struct scoStats *o);
+SCO_API void sco_stats_delete(struct scoStats *o, unsigned long long dtor_ns);
+SCO_API void sco_stats_failed(struct scoStats *o);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,92 @@
+/* SCOOP Trace module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef scoop_Trace_h
+#define scoop_Trace_h
+#include "Object.h"
+#include <stdio.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+   Tracing of virtual calls, for finding out which virtual methods of
+   which classes are called the most, and what they cost.
+
+   Tracing is compiled into the code making the calls, by defining
+   SCO_TRACE when compiling it (e.g. using "make FEATURES=-DSCO_TRACE"
+   after "make clean"). sco_virt() and sco_svirt() then count each call
+   by class and virtual slot, and time one in every SCO_TRACE_PERIOD
+   calls made by a thread. Timing uses the processor's time-stamp
+   counter where available (cycles on x86), and is inclusive, i.e. the
+   time of a call includes that of calls made by it. Tracing needs GCC
+   extensions (statement expressions and the cleanup attribute).
+
+   Without SCO_TRACE, the macros are left as they are, with no cost.
+   Other calls, e.g. by sco_virt_batch() and sco_fvirt(), are not
+   traced.
+
+   Each thread records its calls in a table of its own, which is kept
+   after the thread exits. Calls of more distinct methods than the table
+   holds are counted as lost. The tables are summed when read, so that
+   the counts read while other threads make calls are not from a single
+   instant.
+ */
+
+/** Number of calls per timed call, in each thread. */
+#define SCO_TRACE_PERIOD 64
+
+/** Counts for a virtual method of a class, as summed for all threads. */
+typedef struct scoTraceStats {
+	const void *meta; /* meta type of the class */
+	const char *class_name; /* name of the class */
+	const char *method; /* name of the virtual method */
+	unsigned int slot; /* number of the slot in the virtual table */
+	unsigned long long calls; /* number of calls */
+	unsigned long long samples; /* number of calls timed */
+	unsigned long long cycles; /* total time of the calls timed */
+} scoTraceStats;
+
+/** Calls \p func with the counts for each traced method of each class,
+  * passing \p arg along. The methods are given in descending order of
+  * estimated total time, i.e. the average time of a call times the
+  * number of calls.
+  *
+  * Returns zero if memory allocation failed, otherwise non-zero.
+  */
+SCO_API int sco_trace_walk(void (*func)(const scoTraceStats *stats,
+		void *arg), void *arg);
+
+/** Returns the number of calls not counted for lack of space. */
+SCO_API unsigned long long sco_trace_lost(void);
+
+/** Prints a table of the counts for each traced method to \p out, with
+  * the average time of a call, in the order of sco_trace_walk().
+  */
+SCO_API void sco_trace_dump(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
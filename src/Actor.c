@@ -0,0 +1,224 @@
+/* SCOOP Actor module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Actor.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+
+/*
+ * The mailbox of an actor is a stack of messages, which senders push
+ * onto, and which the worker running the actor takes whole and
+ * reverses. The queued flag of the actor is set by whichever thread
+ * puts it in the run queue, and cleared by the worker once it finds
+ * the mailbox empty; a sender which pushes at the same time either
+ * finds the flag clear and queues the actor itself, or is seen by the
+ * worker checking the mailbox again.
+ */
+
+struct scoWorkers {
+	Mutex lock;
+	Cond work; /* signalled when an actor is queued, or on stop */
+	Cond idle; /* broadcast when the queue is empty and none busy */
+	scoActor *head, *tail; /* run queue */
+	unsigned int busy; /* workers running an actor */
+	unsigned char stop;
+	unsigned int count;
+	Thread threads[];
+};
+
+/*
+ * Messages, pooled.
+ */
+
+#define scoMessage_ \
+	struct scoMessage *next; \
+	size_t slot; \
+	void *arg; \
+	union { \
+		char bytes[SCO_MESSAGE_DATA]; \
+		void *p; \
+		long long ll; \
+		double d; \
+	} data;
+#define scoMessage__
+_SCOclassdef(scoMessage);
+_SCOmetainst(scoMessage, scoNone, 0, 0, SCO_POOL);
+
+/* puts \p a last in the run queue */
+static void enqueue(scoWorkers *o, scoActor *a)
+{
+	a->actor_next = 0;
+	mutex_lock(&o->lock);
+	if (o->tail)
+		o->tail->actor_next = a;
+	else
+		o->head = a;
+	o->tail = a;
+	mutex_unlock(&o->lock);
+	cond_signal(&o->work);
+}
+
+static int post(scoActor *a, scoMessage *m)
+{
+	m->next = __atomic_load_n(&a->actor_mail, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&a->actor_mail, &m->next, m, 1,
+				__ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) ;
+	if (!__atomic_load_n(&a->actor_queued, __ATOMIC_SEQ_CST) &&
+	    !__atomic_exchange_n(&a->actor_queued, 1, __ATOMIC_SEQ_CST))
+		enqueue(a->actor_workers, a);
+	return 1;
+}
+
+int sco_actor_post(void *o, size_t slot, void *arg)
+{
+	scoMessage *m = sco_raw_new(0, sco_metaof(scoMessage));
+	if (!m)
+		return 0;
+	m->slot = slot;
+	m->arg = arg;
+	return post(o, m);
+}
+
+int sco_actor_post_copy(void *o, size_t slot, const void *data,
+		size_t size)
+{
+	scoMessage *m;
+	if (size > SCO_MESSAGE_DATA ||
+	    !(m = sco_raw_new(0, sco_metaof(scoMessage))))
+		return 0;
+	m->slot = slot;
+	memcpy(m->data.bytes, data, size);
+	m->arg = m->data.bytes;
+	return post(o, m);
+}
+
+/* runs the messages in the mailbox of \p a, returning non-zero if the
+ * actor is to be queued again */
+static int run(scoActor *a)
+{
+	scoMessage *m = __atomic_exchange_n(&a->actor_mail, 0,
+			__ATOMIC_ACQUIRE), *prev = 0, *next;
+	scoHandler *virt = (scoHandler*) &a->meta->virt;
+	for (; m; m = next) {
+		next = m->next;
+		m->next = prev;
+		prev = m;
+	}
+	for (m = prev; m; m = next) {
+		next = m->next;
+		virt[m->slot](a, m->arg);
+		sco_delete(m);
+	}
+	if (__atomic_load_n(&a->actor_mail, __ATOMIC_RELAXED))
+		return 1;
+	__atomic_store_n(&a->actor_queued, 0, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&a->actor_mail, __ATOMIC_SEQ_CST) &&
+		!__atomic_exchange_n(&a->actor_queued, 1, __ATOMIC_SEQ_CST);
+}
+
+static ThreadResult THREAD_CALL worker(void *arg)
+{
+	scoWorkers *o = arg;
+	mutex_lock(&o->lock);
+	for (;;) {
+		scoActor *a;
+		while (!o->head && !o->stop)
+			cond_wait(&o->work, &o->lock);
+		if (!(a = o->head))
+			break;
+		if (!(o->head = a->actor_next))
+			o->tail = 0;
+		++o->busy;
+		mutex_unlock(&o->lock);
+		if (run(a))
+			enqueue(o, a);
+		mutex_lock(&o->lock);
+		if (!--o->busy && !o->head)
+			cond_broadcast(&o->idle);
+	}
+	mutex_unlock(&o->lock);
+	return 0;
+}
+
+static void stop(scoWorkers *o, unsigned int started)
+{
+	unsigned int i;
+	mutex_lock(&o->lock);
+	o->stop = 1;
+	mutex_unlock(&o->lock);
+	cond_broadcast(&o->work);
+	for (i = 0; i < started; ++i)
+		thread_join(o->threads[i]);
+	cond_destroy(&o->idle);
+	cond_destroy(&o->work);
+	mutex_destroy(&o->lock);
+	free(o);
+}
+
+scoWorkers *sco_workers_create(unsigned int threads)
+{
+	scoWorkers *o;
+	unsigned int i;
+	if (!threads)
+		threads = cpu_count();
+	if (!(o = calloc(1, sizeof(scoWorkers) + threads * sizeof(Thread))))
+		return 0;
+	mutex_init(&o->lock);
+	cond_init(&o->work);
+	cond_init(&o->idle);
+	o->count = threads;
+	for (i = 0; i < threads; ++i) {
+		if (!thread_create(&o->threads[i], worker, o)) {
+			stop(o, i);
+			return 0;
+		}
+	}
+	return o;
+}
+
+void sco_workers_wait(scoWorkers *o)
+{
+	mutex_lock(&o->lock);
+	while (o->head || o->busy)
+		cond_wait(&o->idle, &o->lock);
+	mutex_unlock(&o->lock);
+}
+
+void sco_workers_destroy(scoWorkers *o)
+{
+	stop(o, o->count);
+}
+
+/*
+ * The actor base class.
+ */
+
+SCOmetainst(scoActor, scoNone, 0, 0);
+
+SCOctordef(scoActor, sco_Actor,, (scoActor *o, scoWorkers *workers),
+		(o, workers))
+{
+	o->actor_workers = workers;
+	return 1;
+}
@@ -0,0 +1,160 @@
+/* SCOOP Arena module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Arena.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CHUNK_BYTES 65536
+#define ALIGN 16 /* alignment of all allocations */
+#define ALIGN_UP(size) (((size) + (ALIGN - 1)) & ~(size_t)(ALIGN - 1))
+/* padding needed to align \p p to \p align, a power of two */
+#define ALIGN_PAD(p, align) \
+	((size_t)(-(uintptr_t)(p)) & ((align) - 1))
+
+/* chunks begin with a header, padded to keep alignment */
+typedef struct Chunk {
+	struct Chunk *prev;
+	size_t size;
+} Chunk;
+#define CHUNK_HEAD ALIGN_UP(sizeof(Chunk))
+
+struct scoArena {
+	Chunk *chunk; /* current chunk, linking to previous ones */
+	char *pos, *end; /* free part of current chunk */
+	size_t chunk_size;
+	void **objs; /* objects to destroy, oldest first */
+	size_t obj_count, obj_alloc;
+};
+
+scoArena *sco_arena_create(size_t chunk_size)
+{
+	scoArena *o = calloc(1, sizeof(scoArena));
+	if (!o)
+		return 0;
+	o->chunk_size = chunk_size ? ALIGN_UP(chunk_size) : CHUNK_BYTES;
+	return o;
+}
+
+void sco_arena_destroy(scoArena *o)
+{
+	sco_arena_clear(o);
+	free(o->chunk);
+	free(o->objs);
+	free(o);
+}
+
+void sco_arena_clear(scoArena *o)
+{
+	Chunk *chunk = o->chunk;
+	while (o->obj_count > 0) {
+		void *obj = o->objs[--o->obj_count];
+		if (sco_meta(obj))
+			sco_finalize(obj);
+	}
+	if (!chunk)
+		return;
+	while (chunk->prev) {
+		Chunk *prev = chunk->prev;
+		free(chunk);
+		chunk = prev;
+	}
+	o->chunk = chunk;
+	o->pos = (char*)chunk + CHUNK_HEAD;
+	o->end = (char*)chunk + CHUNK_HEAD + chunk->size;
+}
+
+/* gets uninitialized memory aligned to \p align (a power of two, at
+ * least ALIGN), adding a chunk if needed */
+static void *arena_get(scoArena *o, size_t size, size_t align)
+{
+	char *mem;
+	size_t pad = ALIGN_PAD(o->pos, align);
+	size = ALIGN_UP(size);
+	if ((size_t)(o->end - o->pos) < size + pad) {
+		/* objects too large for a chunk get one of their own */
+		size_t need = size + (align - ALIGN);
+		size_t chunk_size = (need > o->chunk_size) ?
+			need : o->chunk_size;
+		Chunk *chunk = malloc(CHUNK_HEAD + chunk_size);
+		if (!chunk)
+			return 0;
+		chunk->prev = o->chunk;
+		chunk->size = chunk_size;
+		if (chunk_size > o->chunk_size && o->chunk) {
+			/* keep using the current chunk after this one */
+			chunk->prev = o->chunk->prev;
+			o->chunk->prev = chunk;
+			mem = (char*)chunk + CHUNK_HEAD;
+			return mem + ALIGN_PAD(mem, align);
+		}
+		o->chunk = chunk;
+		o->pos = (char*)chunk + CHUNK_HEAD;
+		o->end = o->pos + chunk_size;
+		pad = ALIGN_PAD(o->pos, align);
+	}
+	mem = o->pos + pad;
+	o->pos = mem + size;
+	return mem;
+}
+
+void *sco_arena_alloc(scoArena *o, size_t size)
+{
+	void *mem = arena_get(o, size, ALIGN);
+	if (mem)
+		memset(mem, 0, size);
+	return mem;
+}
+
+/* checks whether instances of a class must be finalized with the arena,
+ * also to unlist or uncount them */
+static int needs_finalize(const scoObject_Meta *meta)
+{
+	return !(meta->flags & SCO_TRIVIAL) || meta->track || meta->stats;
+}
+
+/* only reserves the memory; sco_raw_new(), as called by the *_new()
+ * functions, then links and counts the instance, once */
+void *sco_arena_raw_new(scoArena *o, void *meta)
+{
+	const scoObject_Meta *m = meta;
+	void *mem;
+	sco_meta_init(meta); /* for the alignment */
+	if (needs_finalize(m) && o->obj_count == o->obj_alloc) {
+		size_t alloc = o->obj_alloc ? o->obj_alloc * 2 : 64;
+		void **objs = realloc(o->objs, alloc * sizeof(void*));
+		if (!objs)
+			return 0;
+		o->objs = objs;
+		o->obj_alloc = alloc;
+	}
+	if (!(mem = arena_get(o, (m->size + m->align - 1) &
+					~(size_t)(m->align - 1),
+					(m->align > ALIGN) ? m->align : ALIGN)))
+		return 0;
+	memset(mem, 0, m->size);
+	sco_set_meta(mem, m);
+	if (needs_finalize(m))
+		o->objs[o->obj_count++] = mem;
+	return mem;
+}
@@ -0,0 +1,93 @@
+/* SCOOP CPU module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/CPU.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FEATURES_DONE 0x8000 /* set once detected */
+
+static const struct {
+	const char *name;
+	unsigned int feature;
+} levels[] = {
+	{"sse2", SCO_CPU_SSE2},
+	{"sse4.2", SCO_CPU_SSE4_2},
+	{"avx", SCO_CPU_AVX},
+	{"avx2", SCO_CPU_AVX2},
+	{"avx512f", SCO_CPU_AVX512F},
+};
+#define LEVELS (sizeof(levels) / sizeof(*levels))
+
+static unsigned int detect(void)
+{
+	unsigned int features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) features |= SCO_CPU_SSE2;
+	if (__builtin_cpu_supports("sse4.2")) features |= SCO_CPU_SSE4_2;
+	if (__builtin_cpu_supports("avx")) features |= SCO_CPU_AVX;
+	if (__builtin_cpu_supports("avx2")) features |= SCO_CPU_AVX2;
+	if (__builtin_cpu_supports("avx512f")) features |= SCO_CPU_AVX512F;
+#endif
+	return features;
+}
+
+/* gets the mask for the level named by SCO_CPU, if set */
+static unsigned int env_mask(void)
+{
+	const char *env = getenv("SCO_CPU");
+	unsigned int mask = 0, i;
+	if (!env)
+		return ~0U;
+	if (!strcmp(env, "none"))
+		return 0;
+	for (i = 0; i < LEVELS; ++i) {
+		mask |= levels[i].feature;
+		if (!strcmp(env, levels[i].name))
+			return mask;
+	}
+	sco_warning("Warning: unknown SCO_CPU level %s ignored", env);
+	return ~0U;
+}
+
+unsigned int sco_cpu_features(void)
+{
+	static unsigned int features;
+	unsigned int f = __atomic_load_n(&features, __ATOMIC_RELAXED);
+	if (!(f & FEATURES_DONE)) {
+		/* racing threads get the same result */
+		f = (detect() & env_mask()) | FEATURES_DONE;
+		__atomic_store_n(&features, f, __ATOMIC_RELAXED);
+	}
+	return f & ~FEATURES_DONE;
+}
+
+scoCPUFunc sco_cpu_select(const scoCPUImpl *impls)
+{
+	unsigned int features = sco_cpu_features();
+	while ((impls->features & features) != impls->features)
+		++impls;
+	return impls->func;
+}
@@ -0,0 +1,205 @@
+/* SCOOP Epoch module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Epoch.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+#ifdef WIN32
+# include <malloc.h>
+#endif
+
+/*
+ * The global epoch is advanced when each reader in a read section has
+ * seen the current one. An object retired in epoch e is queued in the
+ * limbo list for e, and deleted on advancing to e + 2, when the list
+ * is reused; by then, every reader has left any read section in which
+ * it could have found the object.
+ *
+ * Retiring and advancing take a lock, while readers only write their
+ * own record. Objects are deleted after releasing the lock, so that
+ * destructors may retire other objects.
+ */
+
+#define RETIRE_BATCH 64 /* retirements between attempts to advance */
+#define READER_ALIGN 64
+
+typedef struct Reader {
+	struct Reader *next; /* in list of all, newest first */
+	unsigned long state; /* epoch times 2, plus 1 while reading */
+	unsigned char used; /* set while registered to a thread */
+} __attribute__((aligned(READER_ALIGN))) Reader;
+
+typedef struct Limbo {
+	void **objs;
+	size_t count, alloc;
+} Limbo;
+
+static unsigned char epoch_lock;
+static unsigned long epoch;
+static Limbo limbo[2];
+static unsigned int retired; /* since the last attempt to advance */
+static unsigned int deleting; /* lists taken but not yet deleted */
+static Reader *reader_list;
+
+static __thread Reader *self __attribute__((tls_model("initial-exec")));
+static __thread unsigned int depth; /* of nested read sections */
+
+int sco_epoch_register(void)
+{
+	Reader *r;
+	if (self)
+		return 1;
+	for (r = __atomic_load_n(&reader_list, __ATOMIC_ACQUIRE); r;
+	     r = r->next)
+		if (!__atomic_load_n(&r->used, __ATOMIC_RELAXED) &&
+		    !__atomic_test_and_set(&r->used, __ATOMIC_ACQUIRE)) {
+			self = r;
+			return 1;
+		}
+#ifdef WIN32
+	if (!(r = _aligned_malloc(sizeof(Reader), READER_ALIGN)))
+		return 0;
+#else
+	{
+		void *mem;
+		if (posix_memalign(&mem, READER_ALIGN, sizeof(Reader)))
+			return 0;
+		r = mem;
+	}
+#endif
+	memset(r, 0, sizeof(Reader));
+	r->used = 1;
+	r->next = __atomic_load_n(&reader_list, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&reader_list, &r->next, r, 1,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+	self = r;
+	return 1;
+}
+
+void sco_epoch_unregister(void)
+{
+	if (self && !depth) {
+		__atomic_clear(&self->used, __ATOMIC_RELEASE);
+		self = 0;
+	}
+}
+
+void sco_epoch_enter(void)
+{
+	if (depth++)
+		return;
+	__atomic_store_n(&self->state,
+			__atomic_load_n(&epoch, __ATOMIC_ACQUIRE) * 2 + 1,
+			__ATOMIC_RELAXED);
+	/* the state must be visible before reading any shared object */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void sco_epoch_exit(void)
+{
+	if (--depth)
+		return;
+	__atomic_store_n(&self->state, 0, __ATOMIC_RELEASE);
+}
+
+static void delete_all(Limbo *list)
+{
+	size_t i;
+	for (i = 0; i < list->count; ++i)
+		sco_delete(list->objs[i]);
+	free(list->objs);
+	__atomic_sub_fetch(&deleting, 1, __ATOMIC_RELEASE);
+}
+
+/* advances the epoch if every reader in a read section has seen it,
+ * deleting the objects then safe to delete; returns zero if not */
+static int advance(void)
+{
+	Limbo list;
+	Reader *r;
+	unsigned long e;
+	lock(&epoch_lock);
+	e = epoch;
+	retired = 0;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	for (r = __atomic_load_n(&reader_list, __ATOMIC_ACQUIRE); r;
+	     r = r->next) {
+		unsigned long state = __atomic_load_n(&r->state,
+				__ATOMIC_ACQUIRE);
+		if ((state & 1) && state >> 1 != e) {
+			unlock(&epoch_lock);
+			return 0;
+		}
+	}
+	__atomic_store_n(&epoch, e + 1, __ATOMIC_RELEASE);
+	list = limbo[(e + 1) % 2];
+	memset(&limbo[(e + 1) % 2], 0, sizeof(Limbo));
+	__atomic_add_fetch(&deleting, 1, __ATOMIC_RELAXED);
+	unlock(&epoch_lock);
+	delete_all(&list);
+	return 1;
+}
+
+int sco_retire(void *o)
+{
+	Limbo *list;
+	int batch;
+	lock(&epoch_lock);
+	list = &limbo[epoch % 2];
+	if (list->count == list->alloc) {
+		size_t alloc = list->alloc ? list->alloc * 2 : RETIRE_BATCH;
+		void **objs = realloc(list->objs, alloc * sizeof(void*));
+		if (!objs) {
+			unlock(&epoch_lock);
+			return 0;
+		}
+		list->objs = objs;
+		list->alloc = alloc;
+	}
+	list->objs[list->count++] = o;
+	batch = (++retired == RETIRE_BATCH);
+	unlock(&epoch_lock);
+	if (batch)
+		advance();
+	return 1;
+}
+
+void sco_epoch_reclaim(void)
+{
+	int i;
+	for (i = 0; i < 2 && advance(); ++i) ;
+}
+
+void sco_epoch_sync(void)
+{
+	int i;
+	for (i = 0; i < 2; ) {
+		if (advance())
+			++i;
+		else
+			backoff();
+	}
+	while (__atomic_load_n(&deleting, __ATOMIC_ACQUIRE))
+		backoff();
+}
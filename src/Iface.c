@@ -0,0 +1,155 @@
+/* SCOOP Iface module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Iface.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * The interface table of a class has a power of two entries, at least
+ * two, indexed by the top bits of the address of an interface times a
+ * multiplier. Multipliers are tried until one gives each interface of
+ * the class an entry of its own, doubling the size after a number of
+ * tries, so that a lookup reads a single entry.
+ */
+
+#define TRIES 32 /* multipliers tried for each size */
+
+const scoIfaceEntry sco_iface_none = {0, 0, 0};
+
+static size_t hash(const scoIface *iface, unsigned long long mult,
+		unsigned int shift)
+{
+	return (size_t)(((unsigned long long)(uintptr_t) iface * mult) >>
+			shift);
+}
+
+/* places the \p count interfaces in \p impls in \p o, returning zero
+ * if two of them collide */
+static int place(scoIfaceTable *o, size_t size, const scoImpl *impls,
+		size_t count)
+{
+	size_t i;
+	for (i = 0; i < size; ++i)
+		o->entries[i] = sco_iface_none;
+	for (i = 0; i < count; ++i) {
+		scoIfaceEntry *e = &o->entries[hash(impls[i].iface, o->mult,
+				o->shift)];
+		if (e->iface)
+			return 0;
+		e->iface = impls[i].iface;
+		e->table = impls[i].table;
+	}
+	return 1;
+}
+
+/* builds the table for \p count interfaces, or returns NULL if memory
+ * allocation failed */
+static scoIfaceTable *build(const scoImpl *impls, size_t count)
+{
+	unsigned long long mult = 0x9E3779B97F4A7C15ULL;
+	unsigned int bits = 1;
+	while (((size_t) 1 << bits) < count)
+		++bits;
+	for (;; ++bits) {
+		size_t size = (size_t) 1 << bits;
+		scoIfaceTable *o = malloc(sizeof(scoIfaceTable) +
+				size * sizeof(scoIfaceEntry));
+		int i;
+		if (!o)
+			return 0;
+		o->shift = 64 - bits;
+		for (i = 0; i < TRIES; ++i) {
+			o->mult = mult;
+			if (place(o, size, impls, count))
+				return o;
+			mult = (mult * 6364136223846793005ULL +
+					1442695040888963407ULL) | 1;
+		}
+		free(o);
+	}
+}
+
+static int listed(const scoImpl *impls, size_t count, const scoIface *iface)
+{
+	size_t i;
+	for (i = 0; i < count; ++i)
+		if (impls[i].iface == iface)
+			return 1;
+	return 0;
+}
+
+int sco_iface_init(void *_meta)
+{
+	scoObject_Meta *meta = _meta;
+	const scoIfaceTable *super = meta->super ? meta->super->ifaces : 0;
+	size_t count = 0, super_size = 0, i;
+	scoImpl *impls;
+	scoIfaceTable *o;
+	if (meta->impls)
+		while (meta->impls[count].iface) ++count;
+	if (super)
+		super_size = (size_t) 1 << (64 - super->shift);
+	if (!count && !super_size) {
+		meta->ifaces = 0;
+		return 1;
+	}
+	if (!(impls = malloc((count + super_size) * sizeof(scoImpl))))
+		return 0;
+	/* the class's own, then those inherited and not overridden */
+	count = 0;
+	for (i = 0; meta->impls && meta->impls[i].iface; ++i)
+		if (!listed(impls, count, meta->impls[i].iface))
+			impls[count++] = meta->impls[i];
+	for (i = 0; i < super_size; ++i) {
+		const scoIfaceEntry *e = &super->entries[i];
+		if (e->iface && !listed(impls, count, e->iface)) {
+			impls[count].iface = e->iface;
+			impls[count++].table = e->table;
+		}
+	}
+	o = build(impls, count);
+	free(impls);
+	if (!o)
+		return 0;
+	for (i = 0; i < ((size_t) 1 << (64 - o->shift)); ++i)
+		if (o->entries[i].iface)
+			o->entries[i].meta = meta;
+	meta->ifaces = o;
+	return 1;
+}
+
+const scoIfaceEntry *sco_iface_find(const void *o, const scoIface *iface)
+{
+	const scoIfaceTable *t = ((const scoObject*)o)->meta->ifaces;
+	const scoIfaceEntry *e;
+	if (!t)
+		return &sco_iface_none;
+	e = &t->entries[hash(iface, t->mult, t->shift)];
+	return (e->iface == iface) ? e : &sco_iface_none;
+}
+
+const void *sco_iface_get(const void *o, const scoIface *iface)
+{
+	return sco_iface_find(o, iface)->table;
+}
@@ -22,73 +22,985 @@
  */
 
 #include <scoop/Object.h>
+#include <scoop/Iface.h>
+#include <scoop/Registry.h>
+#include <scoop/Stats.h>
 #include <string.h>
+#include "thread.h"
+#ifdef WIN32
+# include <malloc.h>
+#endif
 
 static void pure_virtual(void)
 {
 	sco_fatal("Error: pure virtual SCOOP method called!");
 }
 
-/* recursively fills in blank parts of meta type instance chain */
+/* states of the meta type \a done field */
+enum {
+	META_FRESH = 0,
+	META_DONE = 1,
+	META_BUSY = 2,
+};
+
+/*
+ * Instance memory, aligned as required by the class.
+ */
+
+#define MALLOC_ALIGN (2 * sizeof(void*)) /* given by malloc() */
+#define ALIGN_UP(size, align) (((size) + (align) - 1) & ~(size_t)((align) - 1))
+
+/* gets the alignment of instances, which is final once initialized */
+static size_t class_align(const scoObject_Meta *meta)
+{
+	if ((meta->flags & SCO_CACHELINE) && meta->align < SCO_CACHE_LINE)
+		return SCO_CACHE_LINE;
+	return meta->align;
+}
+
+/* allocates \p size bytes aligned to \p align, zero'd if \p zero */
+static void *aligned_alloc_(size_t size, size_t align, int zero)
+{
+	void *mem;
+	if (align <= MALLOC_ALIGN)
+		return zero ? calloc(1, size) : malloc(size);
+#ifdef WIN32
+	if (!(mem = _aligned_malloc(size, align)))
+		return 0;
+#else
+	if (posix_memalign(&mem, align, size))
+		return 0;
+#endif
+	if (zero) memset(mem, 0, size);
+	return mem;
+}
+
+static void aligned_free(void *mem, size_t align)
+{
+#ifdef WIN32
+	if (align > MALLOC_ALIGN) {
+		_aligned_free(mem);
+		return;
+	}
+#else
+	(void)align;
+#endif
+	free(mem);
+}
+
+static void *instance_alloc(const scoObject_Meta *meta, int zero)
+{
+	return aligned_alloc_(ALIGN_UP(meta->size, meta->align),
+			meta->align, zero);
+}
+
+static void instance_free(const scoObject_Meta *meta, void *o)
+{
+	aligned_free(o, meta->align);
+}
+
+/*
+ * Slab pools. Free slots are zero'd except for the first word, which
+ * links them into a free list.
+ *
+ * In front of the free list, each thread using a pool has a cache of
+ * two magazines, arrays of zero'd slots, which it takes slots from and
+ * puts them into without locking. When both are empty or full, a
+ * magazine is exchanged with the depot of the pool, a list of full
+ * magazines and one of empty ones, under its lock; when no full one is
+ * there, one is filled from the free list. The magazines of a thread
+ * which exits are emptied into the free list.
+ */
+
+#define POOL_SLAB_BYTES 16384
+#define POOL_SLAB_HEAD 16 /* space for slab list link, keeping alignment */
+#define MAG_SLOTS 32
+
+typedef struct Magazine {
+	struct Magazine *next; /* in depot list */
+	size_t count;
+	void *slots[MAG_SLOTS];
+} Magazine;
+
+/* the magazines of a thread for a pool; one of them is always either
+ * full or empty */
+typedef struct Cache {
+	struct Cache *next; /* in list of the pool's caches */
+	struct scoPool *pool;
+	Magazine *loaded, *previous;
+	size_t allocs;
+} Cache;
+
+struct scoPool {
+	unsigned char lock;
+	unsigned char dirty; /* slots are not zeroed, if prototyped */
+	unsigned int index; /* of the caches of the pool in each thread */
+	size_t size, align, head, slab_slots;
+	void *free, *slabs;
+	Magazine *full, *empty; /* the depot */
+	size_t full_count;
+	Cache *caches;
+	size_t slab_count, used, peak, allocs;
+};
+
+/* the number of pools, indexing the caches of each thread */
+static unsigned int pool_count;
+static __thread Cache **thread_caches;
+static __thread size_t thread_cache_count;
+
+static ThreadKey key;
+
+/* counts are only written by the owning thread, but may be read by
+ * others at the same time */
+#define SET(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELAXED)
+
+static size_t pool_default_slots(size_t size)
+{
+	size_t slots = (POOL_SLAB_BYTES - POOL_SLAB_HEAD) / size;
+	return (slots > 16) ? slots : 16;
+}
+
+/* sets the slot layout for the class, before any slab is allocated */
+static void pool_layout(struct scoPool *o, const scoObject_Meta *meta)
+{
+	o->align = class_align(meta);
+	o->size = ALIGN_UP(meta->size, o->align);
+	o->head = ALIGN_UP(POOL_SLAB_HEAD, o->align);
+}
+
+static struct scoPool *pool_create(const scoObject_Meta *meta,
+		size_t slab_slots)
+{
+	struct scoPool *o = calloc(1, sizeof(struct scoPool));
+	if (!o)
+		return 0;
+	pool_layout(o, meta);
+	o->slab_slots = slab_slots ? slab_slots :
+		pool_default_slots(o->size);
+	o->index = __atomic_fetch_add(&pool_count, 1, __ATOMIC_RELAXED);
+	return o;
+}
+
+/* takes a slot from the free list, allocating a new slab if none is
+ * free and \p grow is set; the lock must be held */
+static void *pool_take(struct scoPool *o, int grow)
+{
+	void **slot;
+	if (!o->free) {
+		char *slab;
+		size_t i;
+		if (!grow || !(slab = aligned_alloc_(o->head +
+				o->slab_slots * o->size, o->align, 1)))
+			return 0;
+		*(void**)slab = o->slabs;
+		o->slabs = slab;
+		++o->slab_count;
+		slab += o->head;
+		for (i = o->slab_slots; i-- > 0; ) {
+			slot = (void**)(slab + i * o->size);
+			*slot = o->free;
+			o->free = slot;
+		}
+	}
+	slot = o->free;
+	o->free = *slot;
+	if (++o->used > o->peak) o->peak = o->used;
+	*slot = 0;
+	return slot;
+}
+
+/* returns a zero'd slot to the free list; the lock must be held */
+static void pool_give(struct scoPool *o, void *mem)
+{
+	*(void**)mem = o->free;
+	o->free = mem;
+	--o->used;
+}
+
+/* frees the caches of a thread which exits, emptying their magazines
+ * into the free lists */
+static void EXIT_CALL caches_exit(void *arg)
+{
+	Cache **caches = arg;
+	size_t i, j;
+	for (i = 0; i < thread_cache_count; ++i) {
+		Cache *c = caches[i], **link;
+		struct scoPool *o;
+		if (!c)
+			continue;
+		o = c->pool;
+		lock(&o->lock);
+		for (link = &o->caches; *link != c; link = &(*link)->next) ;
+		*link = c->next;
+		for (j = 0; j < c->loaded->count; ++j)
+			pool_give(o, c->loaded->slots[j]);
+		for (j = 0; j < c->previous->count; ++j)
+			pool_give(o, c->previous->slots[j]);
+		o->allocs += c->allocs;
+		unlock(&o->lock);
+		free(c->loaded);
+		free(c->previous);
+		free(c);
+	}
+	free(caches);
+	thread_caches = 0;
+	thread_cache_count = 0;
+}
+
+/* makes the cache of the calling thread for the pool, returning NULL
+ * on failure, in which case the free list is used directly */
+static Cache *cache_create(struct scoPool *o)
+{
+	Cache *c;
+	if (!thread_key_make(&key, caches_exit))
+		return 0;
+	if (o->index >= thread_cache_count) {
+		size_t count = o->index + 1;
+		Cache **caches = realloc(thread_caches,
+				count * sizeof(Cache*));
+		if (!caches)
+			return 0;
+		memset(caches + thread_cache_count, 0,
+				(count - thread_cache_count) * sizeof(Cache*));
+		thread_caches = caches;
+		thread_cache_count = count;
+		if (!thread_key_set(&key, caches))
+			return 0;
+	}
+	if (!(c = calloc(1, sizeof(Cache))) ||
+	    !(c->loaded = calloc(1, sizeof(Magazine))) ||
+	    !(c->previous = calloc(1, sizeof(Magazine)))) {
+		if (c) free(c->loaded);
+		free(c);
+		return 0;
+	}
+	c->pool = o;
+	lock(&o->lock);
+	c->next = o->caches;
+	o->caches = c;
+	unlock(&o->lock);
+	return thread_caches[o->index] = c;
+}
+
+static Cache *cache_get(struct scoPool *o)
+{
+	if (o->index < thread_cache_count && thread_caches[o->index])
+		return thread_caches[o->index];
+	return cache_create(o);
+}
+
+/* refills the empty loaded magazine, returning zero if no slot could be
+ * allocated */
+static int cache_reload(Cache *c)
+{
+	struct scoPool *o = c->pool;
+	Magazine *m = c->loaded;
+	if (c->previous->count) {
+		SET(c->loaded, c->previous);
+		SET(c->previous, m);
+		return 1;
+	}
+	lock(&o->lock);
+	if (o->full) {
+		c->previous->next = o->empty;
+		o->empty = c->previous;
+		SET(c->previous, m);
+		SET(c->loaded, o->full);
+		o->full = o->full->next;
+		--o->full_count;
+	} else {
+		void *slot;
+		while (m->count < MAG_SLOTS &&
+		       (slot = pool_take(o, !m->count)) != NULL)
+			m->slots[m->count++] = slot;
+	}
+	unlock(&o->lock);
+	return c->loaded->count != 0;
+}
+
+/* makes room in the full loaded magazine, returning zero if no empty
+ * magazine could be allocated */
+static int cache_unload(Cache *c)
+{
+	struct scoPool *o = c->pool;
+	Magazine *m = c->loaded;
+	if (!c->previous->count) {
+		SET(c->loaded, c->previous);
+		SET(c->previous, m);
+		return 1;
+	}
+	lock(&o->lock);
+	if (!(m = o->empty)) {
+		unlock(&o->lock);
+		if (!(m = calloc(1, sizeof(Magazine))))
+			return 0;
+		lock(&o->lock);
+	} else {
+		o->empty = m->next;
+	}
+	c->previous->next = o->full;
+	o->full = c->previous;
+	++o->full_count;
+	SET(c->previous, c->loaded);
+	SET(c->loaded, m);
+	unlock(&o->lock);
+	return 1;
+}
+
+/* takes a slot, zero'd unless dirty, allocating a new slab if none free */
+static void *pool_get(struct scoPool *o)
+{
+	Cache *c = cache_get(o);
+	void *slot;
+	if (!c) {
+		lock(&o->lock);
+		if ((slot = pool_take(o, 1)) != NULL)
+			++o->allocs;
+		unlock(&o->lock);
+		return slot;
+	}
+	if (!c->loaded->count && !cache_reload(c))
+		return 0;
+	SET(c->loaded->count, c->loaded->count - 1);
+	SET(c->allocs, c->allocs + 1);
+	return c->loaded->slots[c->loaded->count];
+}
+
+static void pool_put(struct scoPool *o, void *mem)
+{
+	Cache *c = cache_get(o);
+	if (!o->dirty) memset(mem, 0, o->size);
+	if (!c || (c->loaded->count == MAG_SLOTS && !cache_unload(c))) {
+		lock(&o->lock);
+		pool_give(o, mem);
+		unlock(&o->lock);
+		return;
+	}
+	c->loaded->slots[c->loaded->count] = mem;
+	SET(c->loaded->count, c->loaded->count + 1);
+}
+
+/* returns \p n slots at once, filling the magazines of the thread and
+ * then taking the lock once for the rest, which go into full magazines
+ * of the depot while there are empty ones, and else into the free list */
+static void pool_put_n(struct scoPool *o, void **mems, size_t n)
+{
+	Cache *c = cache_get(o);
+	size_t i;
+	if (!o->dirty)
+		for (i = 0; i < n; ++i) memset(mems[i], 0, o->size);
+	i = 0;
+	while (c && i < n) {
+		Magazine *m = c->loaded;
+		size_t count = MAG_SLOTS - m->count;
+		if (count > n - i) count = n - i;
+		memcpy(&m->slots[m->count], &mems[i], count * sizeof(void*));
+		SET(m->count, m->count + count);
+		i += count;
+		if (c->previous->count)
+			break;
+		SET(c->loaded, c->previous);
+		SET(c->previous, m);
+	}
+	if (i == n)
+		return;
+	lock(&o->lock);
+	while (n - i >= MAG_SLOTS && o->empty) {
+		Magazine *m = o->empty;
+		o->empty = m->next;
+		memcpy(m->slots, &mems[i], MAG_SLOTS * sizeof(void*));
+		m->count = MAG_SLOTS;
+		m->next = o->full;
+		o->full = m;
+		++o->full_count;
+		i += MAG_SLOTS;
+	}
+	for (; i < n; ++i)
+		pool_give(o, mems[i]);
+	unlock(&o->lock);
+}
+
+int sco_pool_enable(void *_meta, size_t slab_slots)
+{
+	scoObject_Meta *meta = _meta;
+	if (__atomic_load_n(&meta->done, __ATOMIC_ACQUIRE) != 0)
+		return 0;
+	if (meta->pool) {
+		meta->pool->slab_slots = slab_slots ? slab_slots :
+			pool_default_slots(meta->pool->size);
+	} else if (!(meta->pool = pool_create(meta, slab_slots))) {
+		return 0;
+	}
+	meta->flags |= SCO_POOL;
+	return 1;
+}
+
+int sco_pool_stats(const void *_meta, scoPoolStats *stats)
+{
+	const scoObject_Meta *meta = _meta;
+	struct scoPool *o = meta->pool;
+	size_t cached, allocs;
+	const Cache *c;
+	if (!o)
+		return 0;
+	lock(&o->lock);
+	cached = o->full_count * MAG_SLOTS;
+	allocs = o->allocs;
+	for (c = o->caches; c; c = c->next) {
+		const Magazine *loaded = __atomic_load_n(&c->loaded,
+				__ATOMIC_RELAXED);
+		const Magazine *previous = __atomic_load_n(&c->previous,
+				__ATOMIC_RELAXED);
+		cached += __atomic_load_n(&loaded->count, __ATOMIC_RELAXED) +
+			__atomic_load_n(&previous->count, __ATOMIC_RELAXED);
+		allocs += __atomic_load_n(&c->allocs, __ATOMIC_RELAXED);
+	}
+	stats->slot_size = o->size;
+	stats->slab_slots = o->slab_slots;
+	stats->slabs = o->slab_count;
+	stats->slots = o->slab_count * o->slab_slots;
+	stats->used = (o->used > cached) ? o->used - cached : 0;
+	stats->cached = cached;
+	stats->peak = o->peak;
+	stats->allocs = allocs;
+	unlock(&o->lock);
+	return 1;
+}
+
+/*
+ * Prototype instances, made on class initialization.
+ */
+
+struct scoProto {
+	scoCtor ctor;
+	void *instance; /* set once constructed */
+};
+
+int sco_proto_enable(void *_meta, scoCtor ctor)
+{
+	scoObject_Meta *meta = _meta;
+	if (__atomic_load_n(&meta->done, __ATOMIC_ACQUIRE) != 0)
+		return 0;
+	if (!meta->proto && !(meta->proto = calloc(1, sizeof(struct scoProto))))
+		return 0;
+	meta->proto->ctor = ctor;
+	return 1;
+}
+
+/* constructs the prototype, or drops it on failure */
+static void proto_init(scoObject_Meta *meta)
+{
+	struct scoProto *o = meta->proto;
+	void *instance = instance_alloc(meta, 1);
+	if (instance) {
+		sco_set_meta(instance, meta);
+		if (o->ctor(instance)) {
+			o->instance = instance;
+			return;
+		}
+		instance_free(meta, instance);
+	}
+	sco_warning("Warning: no SCOOP prototype for %s, zeroing instances",
+			meta->name);
+	meta->proto = 0;
+	free(o);
+}
+
+/*
+ * Instance tracking, with a circular list for each class, and
+ * a list of tracked subclasses for each class.
+ */
+
+struct scoTrack {
+	unsigned char lock;
+	scoTrackLink list; /* head, linking first and last instance */
+	struct scoTrack *subclasses; /* of first, accessed atomically */
+	struct scoTrack *sibling; /* of next subclass of superclass */
+};
+
+/* the link follows the meta type pointer in a tracked instance */
+#define TRACK_LINK(o) ((scoTrackLink*)((scoObject*)(o) + 1))
+#define TRACK_OBJECT(link) ((scoObject*)(link) - 1)
+
+static struct scoTrack *track_create(const scoObject_Meta *meta)
+{
+	struct scoTrack *o = calloc(1, sizeof(struct scoTrack)), *super;
+	if (!o)
+		return 0;
+	o->list.prev = o->list.next = &o->list;
+	if (meta->super && (super = meta->super->track)) {
+		lock(&super->lock);
+		o->sibling = super->subclasses;
+		__atomic_store_n(&super->subclasses, o, __ATOMIC_RELEASE);
+		unlock(&super->lock);
+	}
+	return o;
+}
+
+static void track_link(struct scoTrack *o, void *obj)
+{
+	scoTrackLink *link = TRACK_LINK(obj);
+	lock(&o->lock);
+	link->prev = o->list.prev;
+	link->next = &o->list;
+	o->list.prev->next = link;
+	o->list.prev = link;
+	unlock(&o->lock);
+}
+
+static void track_unlink(struct scoTrack *o, void *obj)
+{
+	scoTrackLink *link = TRACK_LINK(obj);
+	lock(&o->lock);
+	if (link->next) {
+		link->prev->next = link->next;
+		link->next->prev = link->prev;
+		link->prev = link->next = 0;
+	}
+	unlock(&o->lock);
+}
+
+/* destroys the instances in the list, then in those of subclasses; a
+ * subclass's list is reachable once made, before its class is ready */
+static void clean(struct scoTrack *o, void (*destroy)(void *o))
+{
+	struct scoTrack *sub;
+	for (;;) {
+		scoTrackLink *link;
+		lock(&o->lock);
+		if ((link = o->list.next) == &o->list) {
+			unlock(&o->lock);
+			break;
+		}
+		o->list.next = link->next;
+		link->next->prev = &o->list;
+		link->prev = link->next = 0;
+		unlock(&o->lock);
+		destroy(TRACK_OBJECT(link));
+	}
+	for (sub = __atomic_load_n(&o->subclasses, __ATOMIC_ACQUIRE); sub;
+	     sub = sub->sibling)
+		clean(sub, destroy);
+}
+
+void sco_clean(void *_meta, void (*destroy)(void *o))
+{
+	const scoObject_Meta *meta = _meta;
+	if (__atomic_load_n(&meta->done, __ATOMIC_ACQUIRE) == META_DONE &&
+	    meta->track)
+		clean(meta->track, destroy ? destroy : sco_finalize);
+}
+
+void sco_untrack(void *o)
+{
+	const scoObject_Meta *meta = sco_meta(o);
+	if (meta->track)
+		track_unlink(meta->track, o);
+}
+
+static const scoDtor no_dtors[1] = {0};
+
+/* makes the array of destructors for the chain, setting SCO_TRIVIAL
+ * if there are none; leaves it NULL if out of memory */
+static void init_dtors(scoObject_Meta *o)
+{
+	const scoObject_Meta *meta = o;
+	scoDtor *dtors;
+	size_t count = 0;
+	do {
+		if (meta->virt.dtor) ++count;
+		meta = meta->super;
+	} while (meta);
+	if (!count) {
+		o->dtors = no_dtors;
+		o->flags |= SCO_TRIVIAL;
+		return;
+	}
+	if (!(dtors = malloc((count + 1) * sizeof(scoDtor))))
+		return;
+	count = 0;
+	meta = o;
+	do {
+		if (meta->virt.dtor) dtors[count++] = meta->virt.dtor;
+		meta = meta->super;
+	} while (meta);
+	dtors[count] = 0;
+	o->dtors = dtors;
+}
+
+/* calls the destructors for \p o */
+static void run_dtors(const scoObject_Meta *meta, void *o)
+{
+	const scoDtor *dtor = meta->dtors;
+	if (dtor) {
+		for (; *dtor; ++dtor) (*dtor)(o);
+		return;
+	}
+	do { /* not initialized, or out of memory on it */
+		if (meta->virt.dtor) meta->virt.dtor(o);
+		meta = meta->super;
+	} while (meta);
+}
+
+/* recursively fills in blank parts of meta type instance chain;
+ * safe to call from many threads at once - the first to claim the
+ * meta type does the work, while the rest wait for it to finish */
 static void init_meta(scoObject_Meta *o)
 {
 	void (**virt)() = (void (**)()) &o->virt,
 			 (**super_virtab)() = 0;
 	unsigned int i = 1, max; /* skip dtor */
+	unsigned char state = META_FRESH;
+	if (!__atomic_compare_exchange_n(&o->done, &state, META_BUSY, 0,
+				__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+		while (state != META_DONE) {
+			backoff();
+			state = __atomic_load_n(&o->done, __ATOMIC_ACQUIRE);
+		}
+		return;
+	}
 	if (o->super) {
-		if (!o->super->done)
+		if (__atomic_load_n(&o->super->done, __ATOMIC_ACQUIRE) !=
+				META_DONE)
 			init_meta((scoObject_Meta*)o->super);
+		if (o->super->flags & SCO_FINAL)
+			sco_fatal("Error: SCOOP class %s derives from "
+					"final class %s!",
+					o->name, o->super->name);
+		if (o->vvsize < o->super->vvsize)
+			sco_fatal("Error: SCOOP class %s lacks the virtual "
+					"variables of %s!",
+					o->name, o->super->name);
 		super_virtab = (void (**)()) &o->super->virt;
 		for (max = o->super->vnum; i < max; ++i)
 			if (!virt[i]) virt[i] = super_virtab[i];
+		memcpy((char*)o + o->vvoff,
+				(const char*)o->super + o->super->vvoff,
+				o->super->vvsize);
+		o->depth = o->super->depth + 1;
+		o->flags |= o->super->flags & (SCO_TRACK | SCO_CACHELINE);
+		memcpy(o->display, o->super->display, sizeof(o->display));
 	}
+	if (o->depth < SCO_DISPLAY_MAX)
+		o->display[o->depth] = o;
+	o->align = class_align(o);
+	if (o->pool)
+		pool_layout(o->pool, o);
 	if (o->vtinit)
 		o->vtinit(o);
 	for (max = o->vnum; i < max; ++i)
 		if (!virt[i]) virt[i] = pure_virtual;
-	o->done = 1;
+	if (o->copy || (o->super && (o->super->flags & SCO_COPYHOOK)))
+		o->flags |= SCO_COPYHOOK;
+	if (!sco_iface_init(o))
+		sco_error("Error: no SCOOP interface table for %s", o->name);
+	init_dtors(o);
+	if (o->proto)
+		proto_init(o);
+	if ((o->flags & SCO_POOL) && !o->pool &&
+	    !(o->pool = pool_create(o, 0)))
+		sco_warning("Warning: no SCOOP pool for %s, using calloc()",
+				o->name);
+	if (o->pool && o->proto)
+		o->pool->dirty = 1;
+	if ((o->flags & SCO_TRACK) && !(o->track = track_create(o)))
+		sco_error("Error: no SCOOP instance tracking for %s",
+				o->name);
+#ifdef SCO_STATS
+	if (!o->stats && !(o->stats = sco_stats_create(o)))
+		sco_warning("Warning: no SCOOP stats for %s", o->name);
+#endif
+	if (!sco_registry_add(o))
+		sco_warning("Warning: SCOOP class %s not registered",
+				o->name);
+	__atomic_store_n(&o->done, META_DONE, __ATOMIC_RELEASE);
+}
+
+void sco_meta_init(void *meta)
+{
+	if (__atomic_load_n(&((scoObject_Meta*)meta)->done,
+				__ATOMIC_ACQUIRE) != META_DONE)
+		init_meta(meta);
 }
 
 void* sco_raw_new(void *mem, void *_meta)
 {
 	scoObject_Meta *meta = _meta;
+	const struct scoProto *proto;
+	int zeroed = 0;
+	if (__atomic_load_n(&meta->done, __ATOMIC_ACQUIRE) != META_DONE)
+		init_meta(meta);
+	proto = meta->proto;
 	if (!mem) {
-		if (!(mem = calloc(1, meta->size)))
+		if (meta->pool) {
+			if (!(mem = pool_get(meta->pool)))
+				return 0;
+		} else if (!(mem = instance_alloc(meta, !proto))) {
 			return 0;
-	} else {
-		memset(mem, 0, meta->size);
+		}
+		zeroed = !proto;
 	}
-	if (!meta->done) init_meta(meta);
+	if (proto)
+		memcpy(mem, proto->instance, meta->size);
+	else if (!zeroed)
+		memset(mem, 0, meta->size);
 	sco_set_meta(mem, meta);
+	if (meta->track) track_link(meta->track, mem);
+#ifdef SCO_STATS
+	if (meta->stats) sco_stats_new(meta->stats);
+#endif
 	return mem;
 }
 
+void sco_raw_delete(void *o, void *mem)
+{
+	const scoObject_Meta *meta = sco_meta(o);
+#ifdef SCO_STATS
+	if (meta->stats) sco_stats_failed(meta->stats);
+#endif
+	if (meta->track) track_unlink(meta->track, o);
+	if (mem) {
+		sco_set_metaof(o, scoNone);
+	} else if (meta->pool) {
+		pool_put(meta->pool, o);
+	} else {
+		instance_free(meta, o);
+	}
+}
+
 void sco_delete(void *o)
 {
 	const scoObject_Meta *meta = sco_meta(o);
-	do {
-		if (meta->virt.dtor) meta->virt.dtor(o);
-		meta = meta->super;
-	} while (meta);
-	free(o);
+	struct scoPool *pool = meta->pool;
+#ifdef SCO_STATS
+	struct scoStats *stats = meta->stats;
+	unsigned long long start = sco_stats_now();
+#endif
+	if (meta->track) track_unlink(meta->track, o);
+	run_dtors(meta, o);
+#ifdef SCO_STATS
+	if (stats) sco_stats_delete(stats, sco_stats_now() - start);
+#endif
+	if (pool) {
+		pool_put(pool, o);
+	} else {
+		instance_free(meta, o);
+	}
+}
+
+void sco_delete_n(void *_objs, size_t n)
+{
+	scoObject **objs = _objs;
+	size_t i = 0, j;
+	while (i < n) {
+		const scoObject_Meta *meta = sco_meta(objs[i]);
+		if (!(meta->flags & SCO_TRIVIAL) || meta->track
+#ifdef SCO_STATS
+		    || meta->stats
+#endif
+		   ) {
+			sco_delete(objs[i++]);
+			continue;
+		}
+		for (j = i + 1; j < n && objs[j]->meta == objs[i]->meta; ++j) ;
+		if (meta->pool) {
+			pool_put_n(meta->pool, (void**)&objs[i], j - i);
+		} else {
+			for (; i < j; ++i) instance_free(meta, objs[i]);
+		}
+		i = j;
+	}
 }
 
 void sco_finalize(void *o)
 {
 	const scoObject_Meta *meta = sco_meta(o);
-	do {
-		if (meta->virt.dtor) meta->virt.dtor(o);
-		meta = meta->super;
-	} while (meta);
+#ifdef SCO_STATS
+	struct scoStats *stats = meta->stats;
+	unsigned long long start = sco_stats_now();
+#endif
+	if (meta->track) track_unlink(meta->track, o);
+	run_dtors(meta, o);
+#ifdef SCO_STATS
+	if (stats) sco_stats_delete(stats, sco_stats_now() - start);
+#endif
 	sco_set_metaof(o, scoNone);
 }
 
-/* core of type comparison */
-int sco_rtticheck(const void *submeta, const void *meta)
+/* calls the copy hooks for \p o, base class first; on failure, calls
+ * the destructors for those classes whose hooks succeeded */
+static int run_copies(const scoObject_Meta *meta, void *o, const void *src)
 {
-	const scoObject_Meta *subclass = submeta, *class = meta;
-	if (subclass == class)
+	if (meta->super && (meta->super->flags & SCO_COPYHOOK) &&
+	    !run_copies(meta->super, o, src))
+		return 0;
+	if (meta->copy && !meta->copy(o, src)) {
+		if (meta->super) run_dtors(meta->super, o);
+		return 0;
+	}
+	return 1;
+}
+
+void *sco_clone(const void *o, void *mem)
+{
+	const scoObject_Meta *meta = sco_meta(o);
+	void *copy = mem;
+	if (!copy) {
+		if (meta->pool) {
+			if (!(copy = pool_get(meta->pool)))
+				return 0;
+		} else if (!(copy = instance_alloc(meta, 0))) {
+			return 0;
+		}
+	}
+	memcpy(copy, o, meta->size);
+	if ((meta->flags & SCO_COPYHOOK) && !run_copies(meta, copy, o)) {
+		if (mem) {
+			sco_set_metaof(copy, scoNone);
+		} else if (meta->pool) {
+			pool_put(meta->pool, copy);
+		} else {
+			instance_free(meta, copy);
+		}
+		return 0;
+	}
+	if (meta->track) track_link(meta->track, copy);
+#ifdef SCO_STATS
+	if (meta->stats) sco_stats_new(meta->stats);
+#endif
+	return copy;
+}
+
+size_t sco_clone_n(const void *o, void *mem, size_t n)
+{
+	const scoObject_Meta *meta = sco_meta(o);
+	char *copy = mem;
+	size_t i;
+	if (meta->flags & SCO_COPYHOOK || meta->track
+#ifdef SCO_STATS
+	    || meta->stats
+#endif
+	   ) {
+		for (i = 0; i < n; ++i, copy += meta->size)
+			if (!sco_clone(o, copy))
+				return i;
+		return n;
+	}
+	for (i = 0; i < n; ++i, copy += meta->size)
+		memcpy(copy, o, meta->size);
+	return n;
+}
+
+/*
+ * Grouping of object arrays by class.
+ */
+
+typedef struct Group {
+	const void *meta;
+	size_t count;
+} Group;
+
+#define GROUP_HASH(meta, bits) \
+	((size_t)(((unsigned long long)(size_t)(meta) >> 4) * \
+	          0x9E3779B97F4A7C15ULL >> (64 - (bits))))
+
+typedef struct GroupTable {
+	Group *groups;
+	size_t *slots; /* group index + 1 for each hash slot, 0 if free */
+	size_t count, bits;
+} GroupTable;
+
+static int group_table_grow(GroupTable *o)
+{
+	size_t bits = o->bits ? o->bits + 1 : 4, i;
+	size_t *slots = calloc((size_t)1 << bits, sizeof(size_t));
+	Group *groups = realloc(o->groups, sizeof(Group) << (bits - 1));
+	if (!slots || !groups) {
+		free(slots);
+		if (groups) o->groups = groups;
+		return 0;
+	}
+	for (i = 0; i < o->count; ++i) {
+		size_t j = GROUP_HASH(groups[i].meta, bits);
+		while (slots[j]) j = (j + 1) & (((size_t)1 << bits) - 1);
+		slots[j] = i + 1;
+	}
+	free(o->slots);
+	o->groups = groups;
+	o->slots = slots;
+	o->bits = bits;
+	return 1;
+}
+
+/* returns the group for meta, adding it if new, or NULL on failure */
+static Group *group_table_get(GroupTable *o, const void *meta)
+{
+	size_t i;
+	if (o->count >= ((size_t)1 << o->bits) / 2 && !group_table_grow(o))
 		return 0;
+	i = GROUP_HASH(meta, o->bits);
+	while (o->slots[i]) {
+		Group *group = &o->groups[o->slots[i] - 1];
+		if (group->meta == meta)
+			return group;
+		i = (i + 1) & (((size_t)1 << o->bits) - 1);
+	}
+	o->slots[i] = ++o->count;
+	o->groups[o->count - 1].meta = meta;
+	o->groups[o->count - 1].count = 0;
+	return &o->groups[o->count - 1];
+}
+
+static int compare_meta(const void *a, const void *b)
+{
+	const scoObject *o_a = *(void*const*)a, *o_b = *(void*const*)b;
+	return (o_a->meta < o_b->meta) ? -1 : (o_a->meta > o_b->meta);
+}
+
+void sco_group_by_meta(void *_objs, size_t n)
+{
+	scoObject **objs = _objs, **sorted = 0;
+	GroupTable table = {0};
+	Group *group = 0;
+	size_t i, runs = 0, offset = 0;
+	for (i = 0; i < n; ++i) {
+		if (i > 0 && objs[i]->meta == objs[i - 1]->meta) {
+			++group->count;
+			continue;
+		}
+		if (!(group = group_table_get(&table, objs[i]->meta)))
+			goto FALLBACK;
+		++group->count;
+		++runs;
+	}
+	if (runs == table.count)
+		goto DONE; /* already grouped */
+	if (!(sorted = malloc(n * sizeof(scoObject*))))
+		goto FALLBACK;
+	for (i = 0; i < table.count; ++i) {
+		size_t count = table.groups[i].count;
+		table.groups[i].count = offset; /* now position for next */
+		offset += count;
+	}
+	for (i = 0; i < n; ++i)
+		sorted[group_table_get(&table, objs[i]->meta)->count++] =
+			objs[i];
+	memcpy(objs, sorted, n * sizeof(scoObject*));
+	goto DONE;
+FALLBACK:
+	/* out of memory; group without keeping the order */
+	qsort(objs, n, sizeof(scoObject*), compare_meta);
+DONE:
+	free(sorted);
+	free(table.groups);
+	free(table.slots);
+}
+
+/* type comparison for a class not yet initialized, e.g. by its vtinit,
+ * walking up the superclass chain */
+static int rtticheck_walk(const scoObject_Meta *subclass,
+		const scoObject_Meta *class)
+{
 	do {
 		subclass = subclass->super;
 		if (subclass == class)
@@ -96,3 +1008,25 @@ int sco_rtticheck(const void *submeta, const void *meta)
 	} while (subclass);
 	return -1;
 }
+
+/* core of type comparison */
+int sco_rtticheck(const void *submeta, const void *meta)
+{
+	const scoObject_Meta *subclass = submeta, *class = meta;
+	unsigned int i;
+	if (subclass == class)
+		return 0;
+	if (!class)
+		return 1; /* scoNone, above every base class */
+	if (__atomic_load_n(&subclass->done, __ATOMIC_ACQUIRE) != META_DONE)
+		return rtticheck_walk(subclass, class);
+	/* an initialized class only has initialized superclasses */
+	if (__atomic_load_n(&class->done, __ATOMIC_ACQUIRE) != META_DONE ||
+	    class->depth >= subclass->depth)
+		return -1;
+	if (class->depth < SCO_DISPLAY_MAX)
+		return (subclass->display[class->depth] == class) ? 1 : -1;
+	for (i = subclass->depth - class->depth; i > 0; --i)
+		subclass = subclass->super;
+	return (subclass == class) ? 1 : -1;
+}
@@ -0,0 +1,270 @@
+/* SCOOP Parallel module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Parallel.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+#ifdef WIN32
+# include <malloc.h>
+#endif
+
+/*
+ * Each thread of a call has a range of the array left to do, which it
+ * takes chunks from the front of, and which others may split off the
+ * back half of when out of work, all under a spinlock per range. A
+ * thread is done once it finds every range empty; work split off but
+ * not yet put in the thief's range then belongs to the thief, which is
+ * still busy. The caller closes the call once done, so that no worker
+ * starts on it late, and waits for those busy to finish.
+ */
+
+#define RANGE_ALIGN 64 /* keeps each on its own cache line */
+#define GRAIN_DIV 8 /* default chunks per initial range */
+
+typedef struct Range {
+	unsigned char lock;
+	size_t begin, end;
+} __attribute__((aligned(RANGE_ALIGN))) Range;
+
+typedef struct Call {
+	scoObject **objs;
+	size_t grain, slot;
+	void *arg;
+	int flags;
+} Call;
+
+struct scoParallel {
+	Mutex lock;
+	Cond work; /* broadcast when a call is opened, or on stop */
+	Cond done; /* broadcast when no worker is busy */
+	Call call;
+	unsigned long number; /* of the latest call */
+	unsigned char open; /* latest call open for workers to join */
+	unsigned char busy; /* a call is in progress */
+	unsigned char stop;
+	unsigned int active; /* workers busy with the call */
+	unsigned int started; /* workers, numbering themselves from 1 */
+	unsigned int count; /* threads, including the caller's */
+	Range *ranges; /* the caller's first */
+	Thread threads[];
+};
+
+/* makes the calls for \p n objects, a run of the same class at a time */
+static void run(const Call *c, scoObject **objs, size_t n)
+{
+	size_t i = 0;
+	if (c->flags & SCO_PARALLEL_GROUP)
+		sco_group_by_meta(objs, n);
+	while (i < n) {
+		const scoObject_Meta *meta = objs[i]->meta;
+		scoParallelFunc func =
+			((scoParallelFunc*) &meta->virt)[c->slot];
+		do
+			func(objs[i], c->arg);
+		while (++i < n && objs[i]->meta == meta);
+	}
+}
+
+/* takes the next chunk of range \p r, returning zero if empty */
+static int take(Range *r, size_t grain, size_t *begin, size_t *end)
+{
+	int found;
+	lock(&r->lock);
+	found = r->begin < r->end;
+	*begin = r->begin;
+	*end = r->begin = (r->end - r->begin > grain) ?
+		r->begin + grain : r->end;
+	unlock(&r->lock);
+	return found;
+}
+
+/* moves the back half of another range, or all of it if no more than a
+ * grain, to range \p self; returns zero if all were empty */
+static int steal(scoParallel *o, unsigned int self)
+{
+	size_t grain = o->call.grain, begin, end;
+	unsigned int i;
+	for (i = 1; i < o->count; ++i) {
+		Range *r = &o->ranges[(self + i) % o->count];
+		lock(&r->lock);
+		begin = r->begin;
+		end = r->end;
+		if (end - begin > grain)
+			begin += (end - begin) / 2;
+		r->end = begin;
+		unlock(&r->lock);
+		if (begin < end) {
+			r = &o->ranges[self];
+			lock(&r->lock);
+			r->begin = begin;
+			r->end = end;
+			unlock(&r->lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* does chunks of the call as thread \p self until none are left */
+static void participate(scoParallel *o, unsigned int self)
+{
+	size_t begin, end;
+	do {
+		while (take(&o->ranges[self], o->call.grain, &begin, &end))
+			run(&o->call, o->call.objs + begin, end - begin);
+	} while (steal(o, self));
+}
+
+static ThreadResult THREAD_CALL worker(void *arg)
+{
+	scoParallel *o = arg;
+	unsigned long seen = 0;
+	unsigned int self;
+	mutex_lock(&o->lock);
+	self = ++o->started;
+	for (;;) {
+		while (o->number == seen && !o->stop)
+			cond_wait(&o->work, &o->lock);
+		if (o->stop)
+			break;
+		seen = o->number;
+		if (!o->open)
+			continue;
+		++o->active;
+		mutex_unlock(&o->lock);
+		participate(o, self);
+		mutex_lock(&o->lock);
+		if (!--o->active)
+			cond_broadcast(&o->done);
+	}
+	mutex_unlock(&o->lock);
+	return 0;
+}
+
+static void stop(scoParallel *o, unsigned int started)
+{
+	unsigned int i;
+	mutex_lock(&o->lock);
+	o->stop = 1;
+	mutex_unlock(&o->lock);
+	cond_broadcast(&o->work);
+	for (i = 0; i < started; ++i)
+		thread_join(o->threads[i]);
+	cond_destroy(&o->done);
+	cond_destroy(&o->work);
+	mutex_destroy(&o->lock);
+#ifdef WIN32
+	_aligned_free(o->ranges);
+#else
+	free(o->ranges);
+#endif
+	free(o);
+}
+
+scoParallel *sco_parallel_create(unsigned int threads)
+{
+	scoParallel *o;
+	unsigned int i;
+	if (!threads)
+		threads = cpu_count();
+	if (!(o = calloc(1, sizeof(scoParallel) +
+			(threads - 1) * sizeof(Thread))))
+		return 0;
+#ifdef WIN32
+	if (!(o->ranges = _aligned_malloc(threads * sizeof(Range),
+			RANGE_ALIGN))) {
+#else
+	if (posix_memalign((void**) &o->ranges, RANGE_ALIGN,
+			threads * sizeof(Range))) {
+#endif
+		free(o);
+		return 0;
+	}
+	memset(o->ranges, 0, threads * sizeof(Range));
+	mutex_init(&o->lock);
+	cond_init(&o->work);
+	cond_init(&o->done);
+	o->count = threads;
+	for (i = 0; i < threads - 1; ++i) {
+		if (!thread_create(&o->threads[i], worker, o)) {
+			stop(o, i);
+			return 0;
+		}
+	}
+	return o;
+}
+
+void sco_parallel_destroy(scoParallel *o)
+{
+	stop(o, o->count - 1);
+}
+
+void sco_parallel_apply(scoParallel *o, void *objs, size_t n,
+		size_t grain, int flags, size_t slot, void *arg)
+{
+	Call call = {objs, grain, slot, arg, flags};
+	size_t share;
+	unsigned int i;
+	if (o) {
+		mutex_lock(&o->lock);
+		if (o->busy || o->count < 2) {
+			mutex_unlock(&o->lock);
+			o = 0;
+		} else {
+			o->busy = 1;
+			mutex_unlock(&o->lock);
+		}
+	}
+	share = o ? n / o->count : n;
+	if (!call.grain)
+		call.grain = share / GRAIN_DIV + 1;
+	if (!o || n <= call.grain) {
+		if (o) {
+			mutex_lock(&o->lock);
+			o->busy = 0;
+			mutex_unlock(&o->lock);
+		}
+		run(&call, objs, n);
+		return;
+	}
+	/* no worker is in a range now, so they are set without locks */
+	for (i = 0; i < o->count; ++i) {
+		o->ranges[i].begin = share * i;
+		o->ranges[i].end = share * (i + 1);
+	}
+	o->ranges[o->count - 1].end = n;
+	mutex_lock(&o->lock);
+	o->call = call;
+	++o->number;
+	o->open = 1;
+	mutex_unlock(&o->lock);
+	cond_broadcast(&o->work);
+	participate(o, 0);
+	mutex_lock(&o->lock);
+	o->open = 0;
+	while (o->active)
+		cond_wait(&o->done, &o->lock);
+	o->busy = 0;
+	mutex_unlock(&o->lock);
+}
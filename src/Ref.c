@@ -0,0 +1,215 @@
+/* SCOOP Ref module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Ref.h>
+#include <stdlib.h>
+#include "thread.h"
+
+/*
+ * The shared count of an object is kept as the number of references
+ * times ONE, plus flags: MERGED once the owner's count has been added
+ * to it, after which all references are counted in it, and QUEUED once
+ * another thread has found it to go below zero and handed the object
+ * to the owner for merging. An object is only merged by its owner, or
+ * by any thread once the owner has exited; while QUEUED, it is only
+ * merged by collecting the queue, so that it is never deleted while
+ * still in a queue.
+ *
+ * Each thread which creates an object gets an owner record, which is
+ * never freed, as objects may point to it long after the thread exits.
+ * On exit, the record is marked dead, after which objects handed to it
+ * are merged by the thread handing them over.
+ */
+
+#define MERGED 1
+#define QUEUED 2
+#define ONE 4
+
+typedef struct scoRefOwner {
+	scoRef *queue; /* objects handed over for merging */
+	int dead; /* set once the thread has exited */
+} Owner;
+
+static Owner no_owner; /* owner of merged objects, no thread's record */
+/* initial-exec, as the record is checked on each retain and release */
+static __thread Owner *self __attribute__((tls_model("initial-exec")));
+
+static ThreadKey key;
+
+/* merges each object in the queue of \p owner, deleting those which
+ * are no longer referenced */
+static void collect(Owner *owner)
+{
+	scoRef *o = __atomic_exchange_n(&owner->queue, 0, __ATOMIC_SEQ_CST);
+	while (o) {
+		scoRef *next = o->ref_next;
+		int local = o->ref_local * ONE;
+		__atomic_store_n(&o->ref_owner, &no_owner, __ATOMIC_RELAXED);
+		o->ref_local = 0;
+		if (__atomic_add_fetch(&o->ref_shared, local + MERGED,
+					__ATOMIC_ACQ_REL) < ONE)
+			sco_delete(o);
+		o = next;
+	}
+}
+
+static void push(scoRef *o)
+{
+	Owner *owner = __atomic_load_n(&o->ref_owner, __ATOMIC_RELAXED);
+	o->ref_next = __atomic_load_n(&owner->queue, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&owner->queue, &o->ref_next, o, 1,
+				__ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) ;
+	if (__atomic_load_n(&owner->dead, __ATOMIC_SEQ_CST))
+		collect(owner);
+}
+
+static void EXIT_CALL owner_exit(void *arg)
+{
+	Owner *o = arg;
+	__atomic_store_n(&o->dead, 1, __ATOMIC_SEQ_CST);
+	self = 0;
+	collect(o);
+}
+
+static Owner *owner_create(void)
+{
+	Owner *o;
+	if (!thread_key_make(&key, owner_exit) ||
+	    !(o = calloc(1, sizeof(Owner))))
+		return 0;
+	if (!thread_key_set(&key, o)) {
+		free(o);
+		return 0;
+	}
+	return self = o;
+}
+
+/* without an owner record, the object is created merged */
+static void ref_init(scoRef *o)
+{
+	Owner *owner = self;
+	if (!owner && !(owner = owner_create())) {
+		o->ref_owner = &no_owner;
+		o->ref_local = 0;
+		o->ref_shared = ONE + MERGED;
+	} else {
+		o->ref_owner = owner;
+		o->ref_local = 1;
+		o->ref_shared = 0;
+	}
+	o->ref_next = 0;
+}
+
+static unsigned char ref_copy(void *o, const void *src)
+{
+	(void) src;
+	ref_init(o);
+	return 1;
+}
+
+static void scoRef_vtinit(scoRef_Meta *o)
+{
+	o->copy = ref_copy;
+}
+SCOmetainst(scoRef, scoNone, 0, scoRef_vtinit);
+
+SCOctordef(scoRef, sco_Ref,, (scoRef *o), (o))
+{
+	ref_init(o);
+	return 1;
+}
+
+void *sco_retain(void *o)
+{
+	scoRef *r = o;
+	if (__atomic_load_n(&r->ref_owner, __ATOMIC_RELAXED) == self)
+		++r->ref_local;
+	else
+		__atomic_fetch_add(&r->ref_shared, ONE, __ATOMIC_RELAXED);
+	return o;
+}
+
+/* called by the owner on dropping its last reference; the object is
+ * left for collect() if queued
+ *
+ * Until merged, the object keeps the owner, so that any thread queueing
+ * it hands it to this one. If other references remain, one is held
+ * while the owner is cleared, as they may be dropped once merged. */
+static void release_owned(scoRef *o)
+{
+	int old = __atomic_load_n(&o->ref_shared, __ATOMIC_RELAXED), new;
+	do {
+		if (old & QUEUED)
+			return;
+		new = (old < ONE) ? (old | MERGED) : ((old + ONE) | MERGED);
+	} while (!__atomic_compare_exchange_n(&o->ref_shared, &old, new, 1,
+				__ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+	if (old < ONE) {
+		sco_delete(o);
+		return;
+	}
+	__atomic_store_n(&o->ref_owner, &no_owner, __ATOMIC_RELAXED);
+	if (__atomic_sub_fetch(&o->ref_shared, ONE, __ATOMIC_ACQ_REL) < ONE)
+		sco_delete(o);
+}
+
+static void release_shared(scoRef *o)
+{
+	int old = __atomic_load_n(&o->ref_shared, __ATOMIC_RELAXED), new;
+	do {
+		new = old - ONE;
+		if (!(new & MERGED) && new < 0)
+			new |= QUEUED;
+	} while (!__atomic_compare_exchange_n(&o->ref_shared, &old, new, 1,
+				__ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+	if (new & MERGED) {
+		if (new < ONE)
+			sco_delete(o);
+	} else if ((new & QUEUED) && !(old & QUEUED)) {
+		push(o);
+	}
+}
+
+void sco_release(void *o)
+{
+	scoRef *r = o;
+	Owner *me = self;
+	if (!r)
+		return;
+	if (__atomic_load_n(&r->ref_owner, __ATOMIC_RELAXED) != me) {
+		release_shared(r);
+		return;
+	}
+	if (!r->ref_local)
+		release_shared(r);
+	else if (!--r->ref_local)
+		release_owned(r);
+	if (__atomic_load_n(&me->queue, __ATOMIC_RELAXED))
+		collect(me);
+}
+
+void sco_ref_collect(void)
+{
+	if (self)
+		collect(self);
+}
@@ -0,0 +1,191 @@
+/* SCOOP Registry module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Registry.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread.h"
+
+/*
+ * The classes are kept in an array indexed by number, and in a hash
+ * table with linear probing. Entries are only ever added, under a lock;
+ * when a table grows, the old one is kept, as readers may still be
+ * using it, and is never freed (the space wasted being at most that of
+ * the current table). Adding a class already present only sets its
+ * number again, so that a meta type may be initialized anew.
+ */
+
+typedef struct Table {
+	struct Table *old; /* replaced table, kept for readers */
+	size_t size; /* number of entries, a power of two */
+	const scoObject_Meta *entries[];
+} Table;
+
+static unsigned char registry_lock;
+static Table *by_id, *by_name;
+static unsigned int class_count;
+static scoClassDecl *decl_list; /* classes defined, newest first */
+
+/* FNV-1a */
+static size_t hash_name(const char *name)
+{
+	size_t h = (size_t) 2166136261U;
+	while (*name)
+		h = (h ^ (unsigned char) *name++) * 16777619U;
+	return h;
+}
+
+static Table *table_create(size_t size, Table *old)
+{
+	Table *o = calloc(1, sizeof(Table) + size * sizeof(void*));
+	if (!o)
+		return 0;
+	o->old = old;
+	o->size = size;
+	return o;
+}
+
+static void name_insert(Table *o, const scoObject_Meta *meta)
+{
+	size_t i = hash_name(meta->name) & (o->size - 1);
+	while (o->entries[i])
+		i = (i + 1) & (o->size - 1);
+	__atomic_store_n(&o->entries[i], meta, __ATOMIC_RELEASE);
+}
+
+/* finds the number of \p meta if already added */
+static unsigned int find_added(const scoObject_Meta *meta)
+{
+	const scoObject_Meta *entry;
+	unsigned int id;
+	size_t i;
+	if (!by_name)
+		return 0;
+	i = hash_name(meta->name) & (by_name->size - 1);
+	while ((entry = by_name->entries[i]) != meta) {
+		if (!entry)
+			return 0;
+		i = (i + 1) & (by_name->size - 1);
+	}
+	for (id = 1; by_id->entries[id - 1] != meta; ++id) ;
+	return id;
+}
+
+int sco_registry_add(void *_meta)
+{
+	scoObject_Meta *meta = _meta;
+	unsigned int id, i;
+	Table *t;
+	lock(&registry_lock);
+	if ((id = find_added(meta))) {
+		meta->id = id;
+		unlock(&registry_lock);
+		return 1;
+	}
+	id = class_count + 1;
+	if (!by_id || id > by_id->size) {
+		if (!(t = table_create(by_id ? by_id->size * 2 : 64, by_id)))
+			goto fail;
+		if (by_id)
+			memcpy(t->entries, by_id->entries,
+					by_id->size * sizeof(void*));
+		__atomic_store_n(&by_id, t, __ATOMIC_RELEASE);
+	}
+	if (!by_name || id * 2 > by_name->size) {
+		if (!(t = table_create(by_name ? by_name->size * 2 : 128,
+						by_name)))
+			goto fail;
+		for (i = 0; i < class_count; ++i) /* keeps first ones first */
+			name_insert(t, by_id->entries[i]);
+		__atomic_store_n(&by_name, t, __ATOMIC_RELEASE);
+	}
+	meta->id = id;
+	__atomic_store_n(&by_id->entries[id - 1], meta, __ATOMIC_RELEASE);
+	name_insert(by_name, meta);
+	__atomic_store_n(&class_count, id, __ATOMIC_RELEASE);
+	unlock(&registry_lock);
+	return 1;
+fail:
+	unlock(&registry_lock);
+	return 0;
+}
+
+void *sco_class_find(const char *name)
+{
+	const Table *t = __atomic_load_n(&by_name, __ATOMIC_ACQUIRE);
+	const scoObject_Meta *meta;
+	size_t i;
+	if (!t)
+		return 0;
+	i = hash_name(name) & (t->size - 1);
+	while ((meta = __atomic_load_n(&t->entries[i], __ATOMIC_ACQUIRE))) {
+		if (!strcmp(meta->name, name))
+			return (void*) meta;
+		i = (i + 1) & (t->size - 1);
+	}
+	return 0;
+}
+
+void sco_class_declare(scoClassDecl *decl)
+{
+	decl->next = __atomic_load_n(&decl_list, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&decl_list, &decl->next, decl, 1,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+}
+
+void *sco_class_load(const char *name)
+{
+	const scoClassDecl *decl;
+	void *meta;
+	if ((meta = sco_class_find(name)))
+		return meta;
+	for (decl = __atomic_load_n(&decl_list, __ATOMIC_ACQUIRE); decl;
+	     decl = decl->next) {
+		if (!strcmp(((const scoObject_Meta*)decl->meta)->name, name)) {
+			sco_meta_init(decl->meta);
+			return decl->meta;
+		}
+	}
+	return 0;
+}
+
+void *sco_class_get(unsigned int id)
+{
+	if (!id || id > __atomic_load_n(&class_count, __ATOMIC_ACQUIRE))
+		return 0;
+	return (void*) __atomic_load_n(&by_id, __ATOMIC_ACQUIRE)->
+		entries[id - 1];
+}
+
+unsigned int sco_class_count(void)
+{
+	return __atomic_load_n(&class_count, __ATOMIC_ACQUIRE);
+}
+
+void sco_class_walk(void (*func)(void *meta, void *arg), void *arg)
+{
+	unsigned int count = sco_class_count(), id;
+	for (id = 1; id <= count; ++id)
+		func(sco_class_get(id), arg);
+}
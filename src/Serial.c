@@ -0,0 +1,515 @@
+/* SCOOP Serial module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Registry.h>
+#include <scoop/Serial.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAGIC "SCO\1"
+#define BUF_SIZE 4096
+#define NAME_MAX_LEN 255
+
+/*
+ * Variable-length numbers, 7 bits per byte, lowest first, the top bit
+ * set in all but the last byte.
+ */
+
+#define NUM_MAX_BYTES ((sizeof(size_t) * 8 + 6) / 7)
+
+static size_t encode_num(unsigned char *buf, size_t v)
+{
+	size_t len = 0;
+	while (v >= 0x80) {
+		buf[len++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	buf[len++] = (unsigned char) v;
+	return len;
+}
+
+/* checks whether objects of a class are written as plain data */
+static int is_raw(const scoObject_Meta *meta)
+{
+	do {
+		if (meta->fields) return 0;
+		meta = meta->super;
+	} while (meta);
+	return 1;
+}
+
+/* start of the members written as plain data, past the tracking link */
+static size_t raw_start(const scoObject_Meta *meta)
+{
+	return sizeof(scoObject) +
+		((meta->flags & SCO_TRACK) ? sizeof(scoTrackLink) : 0);
+}
+
+/*
+ * Writing.
+ */
+
+typedef struct Entry {
+	const void *key; /* object or meta type, or NULL if unused */
+	size_t num;
+} Entry;
+
+typedef struct Writer {
+	scoSerialWrite write;
+	void *arg;
+	int failed;
+	size_t len;
+	/* objects in order of number, the first count written */
+	const scoObject **objs;
+	size_t obj_count, obj_alloc;
+	/* numbers of objects and classes */
+	Entry *table;
+	size_t table_used, table_mask;
+	size_t class_count;
+	unsigned char buf[BUF_SIZE];
+} Writer;
+
+static void flush(Writer *o)
+{
+	if (o->len && !o->failed && !o->write(o->arg, o->buf, o->len))
+		o->failed = 1;
+	o->len = 0;
+}
+
+static void put(Writer *o, const void *data, size_t size)
+{
+	if (size > BUF_SIZE - o->len) {
+		flush(o);
+		if (size >= BUF_SIZE) {
+			if (!o->failed && !o->write(o->arg, data, size))
+				o->failed = 1;
+			return;
+		}
+	}
+	memcpy(o->buf + o->len, data, size);
+	o->len += size;
+}
+
+static void put_num(Writer *o, size_t v)
+{
+	unsigned char num[NUM_MAX_BYTES];
+	put(o, num, encode_num(num, v));
+}
+
+static size_t hash(const void *key)
+{
+	size_t h = (size_t) ((uintptr_t) key >> 3) *
+		(size_t) 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 16);
+}
+
+static int table_grow(Writer *o)
+{
+	size_t mask = o->table_mask ? o->table_mask * 2 + 1 : 255, i, j;
+	Entry *table = calloc(mask + 1, sizeof(Entry));
+	if (!table)
+		return 0;
+	for (i = 0; o->table && i <= o->table_mask; ++i) {
+		if (!o->table[i].key) continue;
+		j = hash(o->table[i].key) & mask;
+		while (table[j].key) j = (j + 1) & mask;
+		table[j] = o->table[i];
+	}
+	free(o->table);
+	o->table = table;
+	o->table_mask = mask;
+	return 1;
+}
+
+/* finds the entry for \p key, adding it with zero number if missing */
+static Entry *table_get(Writer *o, const void *key)
+{
+	size_t i;
+	if (o->table_used * 2 >= o->table_mask && !table_grow(o))
+		return 0;
+	i = hash(key) & o->table_mask;
+	while (o->table[i].key && o->table[i].key != key)
+		i = (i + 1) & o->table_mask;
+	if (!o->table[i].key) {
+		o->table[i].key = key;
+		++o->table_used;
+	}
+	return &o->table[i];
+}
+
+/* gets the number of an object, numbering it if new */
+static size_t number(Writer *o, const scoObject *obj)
+{
+	Entry *e;
+	if (!obj)
+		return 0;
+	if (!(e = table_get(o, obj))) {
+		o->failed = 1;
+		return 0;
+	}
+	if (!e->num) {
+		if (o->obj_count == o->obj_alloc) {
+			size_t alloc = o->obj_alloc ? o->obj_alloc * 2 : 256;
+			const scoObject **objs = realloc(o->objs,
+					alloc * sizeof(*objs));
+			if (!objs) {
+				o->failed = 1;
+				return 0;
+			}
+			o->objs = objs;
+			o->obj_alloc = alloc;
+		}
+		o->objs[o->obj_count] = obj;
+		e->num = ++o->obj_count;
+	}
+	return e->num;
+}
+
+static void put_fields(Writer *o, const scoObject_Meta *meta,
+		const char *obj)
+{
+	const scoField *f;
+	if (meta->super)
+		put_fields(o, meta->super, obj);
+	if (!meta->fields)
+		return;
+	for (f = meta->fields; f->kind; ++f) {
+		if (f->kind == SCO_FIELD_OBJECT)
+			put_num(o, number(o,
+					*(const scoObject *const*)(obj + f->offset)));
+		else
+			put(o, obj + f->offset, f->size);
+	}
+}
+
+static void put_object(Writer *o, const scoObject *obj)
+{
+	const scoObject_Meta *meta = obj->meta;
+	Entry *e = table_get(o, meta);
+	if (!e) {
+		o->failed = 1;
+		return;
+	}
+	if (!e->num) {
+		size_t len = strlen(meta->name);
+		e->num = ++o->class_count;
+		put_num(o, 0);
+		put_num(o, len);
+		put(o, meta->name, len);
+		put_num(o, meta->size);
+	} else {
+		put_num(o, e->num);
+	}
+	if (is_raw(meta)) {
+		size_t start = raw_start(meta);
+		put(o, (const char*)obj + start, meta->size - start);
+	} else {
+		put_fields(o, meta, (const char*)obj);
+	}
+}
+
+int sco_serialize(void *const *roots, size_t n,
+		scoSerialWrite write, void *arg)
+{
+	Writer *o = calloc(1, sizeof(Writer));
+	size_t i;
+	int ok;
+	if (!o)
+		return 0;
+	o->write = write;
+	o->arg = arg;
+	put(o, MAGIC, 4);
+	put_num(o, n);
+	for (i = 0; i < n; ++i)
+		put_num(o, number(o, roots[i]));
+	for (i = 0; i < o->obj_count && !o->failed; ++i)
+		put_object(o, o->objs[i]);
+	flush(o);
+	ok = !o->failed;
+	free(o->objs);
+	free(o->table);
+	free(o);
+	return ok;
+}
+
+/*
+ * Reading.
+ */
+
+typedef struct Class {
+	const scoObject_Meta *meta;
+	int raw; /* -1 until the first instance is made */
+} Class;
+
+typedef struct Reader {
+	scoSerialRead read; /* NULL if reading memory */
+	void *arg;
+	const unsigned char *pos, *end; /* rest of input, or of buffer */
+	void *const *metas;
+	size_t meta_count;
+	/* objects in order of number, the first count read, the rest
+	 * chains of the locations pointing to them */
+	void **objs;
+	size_t obj_count, obj_known, obj_alloc;
+	Class *classes;
+	size_t class_count, class_alloc;
+	void *partial; /* object being read */
+	unsigned char *buf;
+} Reader;
+
+static int get(Reader *o, void *data, size_t size)
+{
+	unsigned char *dst = data;
+	while (size > 0) {
+		size_t n;
+		if (o->pos == o->end) {
+			if (!o->read || !(n = o->read(o->arg, o->buf, BUF_SIZE)))
+				return 0;
+			o->pos = o->buf;
+			o->end = o->buf + n;
+		}
+		n = (size_t) (o->end - o->pos);
+		if (n > size) n = size;
+		memcpy(dst, o->pos, n);
+		o->pos += n;
+		dst += n;
+		size -= n;
+	}
+	return 1;
+}
+
+static int get_num(Reader *o, size_t *v)
+{
+	unsigned int shift = 0;
+	size_t i;
+	*v = 0;
+	for (i = 0; i < NUM_MAX_BYTES; ++i, shift += 7) {
+		unsigned char c;
+		if (o->pos < o->end)
+			c = *o->pos++;
+		else if (!get(o, &c, 1))
+			return 0;
+		*v |= (size_t) (c & 0x7f) << shift;
+		if (!(c & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+/* sets the pointer at \p loc to the object numbered \p num, chaining
+ * it to those pointing to the object if not yet read */
+static int link_object(Reader *o, void **loc, size_t num)
+{
+	if (!num) {
+		*loc = 0;
+		return 1;
+	}
+	if (num <= o->obj_count) {
+		*loc = o->objs[num - 1];
+		return 1;
+	}
+	if (num > o->obj_known + 1) /* numbered in order of reference */
+		return 0;
+	if (num > o->obj_known) {
+		if (o->obj_known == o->obj_alloc) {
+			size_t alloc = o->obj_alloc ? o->obj_alloc * 2 : 256;
+			void **objs = realloc(o->objs, alloc * sizeof(void*));
+			if (!objs)
+				return 0;
+			o->objs = objs;
+			o->obj_alloc = alloc;
+		}
+		o->objs[o->obj_known++] = 0;
+	}
+	*loc = o->objs[num - 1];
+	o->objs[num - 1] = loc;
+	return 1;
+}
+
+static int get_class(Reader *o, Class **cls)
+{
+	char name[NAME_MAX_LEN + 1];
+	const scoObject_Meta *meta = 0;
+	size_t num, len, size, i;
+	if (!get_num(o, &num))
+		return 0;
+	if (num) {
+		if (num > o->class_count)
+			return 0;
+		*cls = &o->classes[num - 1];
+		return 1;
+	}
+	if (!get_num(o, &len) || len > NAME_MAX_LEN || !get(o, name, len) ||
+	    !get_num(o, &size))
+		return 0;
+	name[len] = '\0';
+	if (!o->metas) {
+		meta = sco_class_load(name);
+	} else {
+		for (i = 0; i < o->meta_count; ++i) {
+			if (!strcmp(((const scoObject_Meta*)o->metas[i])->name,
+						name)) {
+				meta = o->metas[i];
+				break;
+			}
+		}
+	}
+	if (!meta || meta->size != size)
+		return 0;
+	if (o->class_count == o->class_alloc) {
+		size_t alloc = o->class_alloc ? o->class_alloc * 2 : 16;
+		Class *classes = realloc(o->classes, alloc * sizeof(Class));
+		if (!classes)
+			return 0;
+		o->classes = classes;
+		o->class_alloc = alloc;
+	}
+	*cls = &o->classes[o->class_count++];
+	(*cls)->meta = meta;
+	(*cls)->raw = -1;
+	return 1;
+}
+
+static int get_fields(Reader *o, const scoObject_Meta *meta, char *obj)
+{
+	const scoField *f;
+	if (meta->super && !get_fields(o, meta->super, obj))
+		return 0;
+	if (!meta->fields)
+		return 1;
+	for (f = meta->fields; f->kind; ++f) {
+		if (f->kind == SCO_FIELD_OBJECT) {
+			size_t num;
+			if (!get_num(o, &num) ||
+			    !link_object(o, (void**)(obj + f->offset), num))
+				return 0;
+		} else if (!get(o, obj + f->offset, f->size)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int get_object(Reader *o)
+{
+	Class *cls;
+	char *obj;
+	void **loc;
+	if (!get_class(o, &cls) ||
+	    !(obj = o->partial = sco_raw_new(0, (void*)cls->meta)))
+		return 0;
+	if (cls->raw < 0)
+		cls->raw = is_raw(cls->meta);
+	if (cls->raw) {
+		size_t start = raw_start(cls->meta);
+		if (!get(o, obj + start, cls->meta->size - start))
+			return 0;
+	} else if (!get_fields(o, cls->meta, obj)) {
+		return 0;
+	}
+	for (loc = o->objs[o->obj_count]; loc; ) {
+		void **next = *loc;
+		*loc = obj;
+		loc = next;
+	}
+	o->objs[o->obj_count++] = obj;
+	o->partial = 0;
+	return 1;
+}
+
+/* deletes the objects read, after clearing the pointers to the rest */
+static void discard(Reader *o, void **roots, size_t n)
+{
+	size_t i;
+	for (i = o->obj_count; i < o->obj_known; ++i) {
+		void **loc = o->objs[i];
+		while (loc) {
+			void **next = *loc;
+			*loc = 0;
+			loc = next;
+		}
+	}
+	if (o->partial)
+		sco_raw_delete(o->partial, 0);
+	for (i = o->obj_count; i-- > 0; )
+		sco_raw_delete(o->objs[i], 0);
+	for (i = 0; i < n; ++i)
+		roots[i] = 0;
+}
+
+static int deserialize(Reader *o, void **roots, size_t n)
+{
+	unsigned char magic[4];
+	size_t count, i;
+	int ok = 0;
+	if (!get(o, magic, 4) || memcmp(magic, MAGIC, 4) ||
+	    !get_num(o, &count) || count != n)
+		goto done;
+	for (i = 0; i < n; ++i) {
+		size_t num;
+		if (!get_num(o, &num) || !link_object(o, &roots[i], num))
+			goto done;
+	}
+	while (o->obj_count < o->obj_known)
+		if (!get_object(o))
+			goto done;
+	ok = 1;
+done:
+	if (!ok)
+		discard(o, roots, n);
+	free(o->objs);
+	free(o->classes);
+	return ok;
+}
+
+int sco_deserialize(void **roots, size_t n,
+		scoSerialRead read, void *arg,
+		void *const *metas, size_t meta_count)
+{
+	Reader o = {0};
+	int ok;
+	if (!(o.buf = malloc(BUF_SIZE)))
+		return 0;
+	o.read = read;
+	o.arg = arg;
+	o.pos = o.end = o.buf;
+	o.metas = metas;
+	o.meta_count = meta_count;
+	ok = deserialize(&o, roots, n);
+	free(o.buf);
+	return ok;
+}
+
+int sco_deserialize_mem(void **roots, size_t n,
+		const void *mem, size_t size,
+		void *const *metas, size_t meta_count)
+{
+	Reader o = {0};
+	o.pos = mem;
+	o.end = o.pos + size;
+	o.metas = metas;
+	o.meta_count = meta_count;
+	return deserialize(&o, roots, n);
+}
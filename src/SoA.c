@@ -0,0 +1,160 @@
+/* SCOOP SoA (structure of arrays) module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/SoA.h>
+#include <string.h>
+#ifdef WIN32
+# include <malloc.h>
+#endif
+
+#define MIN_CAPACITY 64 /* elements, rounding up growth */
+
+static void *column_alloc(size_t size)
+{
+#ifdef WIN32
+	return _aligned_malloc(size, SCO_SOA_ALIGN);
+#else
+	void *mem;
+	return posix_memalign(&mem, SCO_SOA_ALIGN, size) ? 0 : mem;
+#endif
+}
+
+static void column_free(void *mem)
+{
+#ifdef WIN32
+	_aligned_free(mem);
+#else
+	free(mem);
+#endif
+}
+
+#define COLUMNS(o) ((char**)((scoSoA*)(o) + 1))
+
+void sco_soa_setup(scoSoA *o, const void *meta,
+		const scoSoAColumn *columns, size_t column_count)
+{
+	o->meta = meta;
+	o->count = o->capacity = 0;
+	o->columns = columns;
+	o->column_count = column_count;
+	memset(COLUMNS(o), 0, column_count * sizeof(char*));
+}
+
+void sco_soa_fini(void *_o)
+{
+	scoSoA *o = _o;
+	char **cols = COLUMNS(o);
+	size_t i;
+	for (i = 0; i < o->column_count; ++i) {
+		column_free(cols[i]);
+		cols[i] = 0;
+	}
+	o->count = o->capacity = 0;
+}
+
+int sco_soa_reserve(void *_o, size_t capacity)
+{
+	scoSoA *o = _o;
+	char **cols = COLUMNS(o), *resized[64], **new_cols = resized;
+	size_t i;
+	if (capacity <= o->capacity)
+		return 1;
+	capacity = (capacity + MIN_CAPACITY - 1) & ~(size_t)(MIN_CAPACITY - 1);
+	if (o->column_count > sizeof(resized) / sizeof(*resized) &&
+	    !(new_cols = malloc(o->column_count * sizeof(char*))))
+		return 0;
+	/* allocate all columns before changing any, to fail cleanly */
+	for (i = 0; i < o->column_count; ++i) {
+		if (!(new_cols[i] = column_alloc(capacity *
+						o->columns[i].size))) {
+			while (i-- > 0) column_free(new_cols[i]);
+			if (new_cols != resized) free(new_cols);
+			return 0;
+		}
+	}
+	for (i = 0; i < o->column_count; ++i) {
+		if (cols[i]) {
+			memcpy(new_cols[i], cols[i],
+					o->count * o->columns[i].size);
+			column_free(cols[i]);
+		}
+		cols[i] = new_cols[i];
+	}
+	if (new_cols != resized) free(new_cols);
+	o->capacity = capacity;
+	return 1;
+}
+
+size_t sco_soa_push(void *_o, const void *obj)
+{
+	scoSoA *o = _o;
+	if (o->count == o->capacity &&
+	    !sco_soa_reserve(o, o->capacity ? o->capacity * 2 : 1))
+		return (size_t)-1;
+	sco_soa_set(o, o->count, obj);
+	return o->count++;
+}
+
+void sco_soa_erase(void *_o, size_t i)
+{
+	scoSoA *o = _o;
+	char **cols = COLUMNS(o);
+	size_t last = --o->count, j;
+	if (i == last)
+		return;
+	for (j = 0; j < o->column_count; ++j) {
+		size_t size = o->columns[j].size;
+		memcpy(cols[j] + i * size, cols[j] + last * size, size);
+	}
+}
+
+void sco_soa_get(const void *_o, size_t i, void *obj)
+{
+	const scoSoA *o = _o;
+	char *const *cols = COLUMNS(o);
+	size_t j;
+	if (o->meta) {
+		/* a copy, not an instance to count, list or destroy */
+		const scoObject_Meta *meta = o->meta;
+		sco_meta_init((void*)meta);
+		memset(obj, 0, meta->size);
+		sco_set_meta(obj, meta);
+	}
+	for (j = 0; j < o->column_count; ++j) {
+		size_t size = o->columns[j].size;
+		memcpy((char*)obj + o->columns[j].offset,
+				cols[j] + i * size, size);
+	}
+}
+
+void sco_soa_set(void *_o, size_t i, const void *obj)
+{
+	scoSoA *o = _o;
+	char **cols = COLUMNS(o);
+	size_t j;
+	for (j = 0; j < o->column_count; ++j) {
+		size_t size = o->columns[j].size;
+		memcpy(cols[j] + i * size,
+				(const char*)obj + o->columns[j].offset, size);
+	}
+}
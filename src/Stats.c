@@ -0,0 +1,256 @@
+/* SCOOP Stats module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Stats.h>
+#include <string.h>
+#ifdef WIN32
+# include <windows.h>
+# include <malloc.h>
+#else
+# include <time.h>
+#endif
+
+#ifdef SCO_STATS
+
+#define SHARDS 16
+#define SHARD_ALIGN 64
+
+typedef struct Shard {
+	long live, peak;
+	size_t allocs, failures;
+	unsigned long long ctor_ns, dtor_ns;
+} __attribute__((aligned(SHARD_ALIGN))) Shard;
+
+struct scoStats {
+	const scoObject_Meta *meta;
+	struct scoStats *next; /* in list of all, newest first */
+	Shard shards[SHARDS];
+};
+
+static struct scoStats *stats_list;
+static unsigned int shard_count;
+static __thread unsigned int shard_id; /* 0 if none yet, else index + 1 */
+
+/* gets the shard used by the calling thread */
+static Shard *get_shard(struct scoStats *o)
+{
+	if (!shard_id)
+		shard_id = __atomic_fetch_add(&shard_count, 1,
+				__ATOMIC_RELAXED) % SHARDS + 1;
+	return &o->shards[shard_id - 1];
+}
+
+unsigned long long sco_stats_now(void)
+{
+#ifdef WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (unsigned long long)
+		((double)count.QuadPart * 1e9 / freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+struct scoStats *sco_stats_create(const void *meta)
+{
+	struct scoStats *o;
+#ifdef WIN32
+	if (!(o = _aligned_malloc(sizeof(struct scoStats), SHARD_ALIGN)))
+		return 0;
+#else
+	void *mem;
+	if (posix_memalign(&mem, SHARD_ALIGN, sizeof(struct scoStats)))
+		return 0;
+	o = mem;
+#endif
+	memset(o, 0, sizeof(struct scoStats));
+	o->meta = meta;
+	o->next = __atomic_load_n(&stats_list, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&stats_list, &o->next, o, 1,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+	return o;
+}
+
+void sco_stats_new(struct scoStats *o)
+{
+	Shard *shard = get_shard(o);
+	long live = __atomic_add_fetch(&shard->live, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&shard->allocs, 1, __ATOMIC_RELAXED);
+	if (live > __atomic_load_n(&shard->peak, __ATOMIC_RELAXED))
+		__atomic_store_n(&shard->peak, live, __ATOMIC_RELAXED);
+}
+
+void sco_stats_delete(struct scoStats *o, unsigned long long dtor_ns)
+{
+	Shard *shard = get_shard(o);
+	__atomic_sub_fetch(&shard->live, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&shard->dtor_ns, dtor_ns, __ATOMIC_RELAXED);
+}
+
+void sco_stats_failed(struct scoStats *o)
+{
+	Shard *shard = get_shard(o);
+	__atomic_sub_fetch(&shard->live, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&shard->failures, 1, __ATOMIC_RELAXED);
+}
+
+unsigned char sco_stats_ctor_done(const void *meta,
+		unsigned long long start, unsigned char ok)
+{
+	struct scoStats *o = ((const scoObject_Meta*)meta)->stats;
+	if (o)
+		__atomic_add_fetch(&get_shard(o)->ctor_ns,
+				sco_stats_now() - start, __ATOMIC_RELAXED);
+	return ok;
+}
+
+static void sum_stats(const struct scoStats *o, scoClassStats *stats)
+{
+	long live = 0, peak = 0;
+	int i;
+	memset(stats, 0, sizeof(scoClassStats));
+	stats->name = o->meta->name;
+	stats->meta = o->meta;
+	stats->size = o->meta->size;
+	for (i = 0; i < SHARDS; ++i) {
+		const Shard *shard = &o->shards[i];
+		live += __atomic_load_n(&shard->live, __ATOMIC_RELAXED);
+		peak += __atomic_load_n(&shard->peak, __ATOMIC_RELAXED);
+		stats->allocs += __atomic_load_n(&shard->allocs,
+				__ATOMIC_RELAXED);
+		stats->failures += __atomic_load_n(&shard->failures,
+				__ATOMIC_RELAXED);
+		stats->ctor_ns += __atomic_load_n(&shard->ctor_ns,
+				__ATOMIC_RELAXED);
+		stats->dtor_ns += __atomic_load_n(&shard->dtor_ns,
+				__ATOMIC_RELAXED);
+	}
+	if (live < 0) live = 0;
+	if (peak < live) peak = live;
+	stats->live = live;
+	stats->peak = peak;
+	if (stats->peak > stats->allocs)
+		stats->peak = stats->allocs;
+	stats->bytes = stats->live * stats->size;
+}
+
+int sco_stats_get(const void *meta, scoClassStats *stats)
+{
+	const struct scoStats *o = ((const scoObject_Meta*)meta)->stats;
+	if (!o)
+		return 0;
+	sum_stats(o, stats);
+	return 1;
+}
+
+void sco_stats_walk(void (*func)(const scoClassStats *stats, void *arg),
+		void *arg)
+{
+	const struct scoStats *o;
+	scoClassStats stats;
+	for (o = __atomic_load_n(&stats_list, __ATOMIC_ACQUIRE); o;
+	     o = o->next) {
+		sum_stats(o, &stats);
+		func(&stats, arg);
+	}
+}
+
+#else /* !SCO_STATS */
+
+unsigned long long sco_stats_now(void)
+{
+	return 0;
+}
+
+struct scoStats *sco_stats_create(const void *meta)
+{
+	(void)meta;
+	return 0;
+}
+
+void sco_stats_new(struct scoStats *o)
+{
+	(void)o;
+}
+
+void sco_stats_delete(struct scoStats *o, unsigned long long dtor_ns)
+{
+	(void)o;
+	(void)dtor_ns;
+}
+
+void sco_stats_failed(struct scoStats *o)
+{
+	(void)o;
+}
+
+unsigned char sco_stats_ctor_done(const void *meta,
+		unsigned long long start, unsigned char ok)
+{
+	(void)meta;
+	(void)start;
+	return ok;
+}
+
+int sco_stats_get(const void *meta, scoClassStats *stats)
+{
+	(void)meta;
+	(void)stats;
+	return 0;
+}
+
+void sco_stats_walk(void (*func)(const scoClassStats *stats, void *arg),
+		void *arg)
+{
+	(void)func;
+	(void)arg;
+}
+
+#endif /* SCO_STATS */
+
+static void dump_class(const scoClassStats *stats, void *out)
+{
+	fprintf(out, "%-24s %10zu %10zu %12zu %8zu %12zu %10.1f %10.1f\n",
+			stats->name, stats->live, stats->peak,
+			stats->allocs, stats->failures, stats->bytes,
+			stats->allocs ?
+			(double)stats->ctor_ns / stats->allocs : 0.0,
+			(stats->allocs > stats->live + stats->failures) ?
+			(double)stats->dtor_ns / (stats->allocs -
+				stats->live - stats->failures) : 0.0);
+}
+
+void sco_stats_dump(FILE *out)
+{
+	fprintf(out, "%-24s %10s %10s %12s %8s %12s %10s %10s\n",
+			"class", "live", "peak", "allocs", "failed",
+			"bytes", "ctor ns", "dtor ns");
+	sco_stats_walk(dump_class, out);
+}
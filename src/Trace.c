@@ -0,0 +1,226 @@
+/* SCOOP Trace module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Trace.h>
+#include <stdlib.h>
+#if !defined(__x86_64__) && !defined(__i386__)
+# include <time.h>
+#endif
+
+#define ENTRIES 1024 /* per thread, a power of two */
+#define ENTRIES_MAX (ENTRIES / 4 * 3)
+
+struct scoTraceEntry {
+	const void *meta; /* NULL until used, set last */
+	unsigned int slot;
+	const char *name;
+	unsigned long long calls, samples, cycles;
+};
+
+/* the table of a thread */
+typedef struct Buffer {
+	struct Buffer *next; /* in list of all, newest first */
+	unsigned long long count; /* calls, for sampling */
+	unsigned long long lost;
+	size_t used;
+	struct scoTraceEntry entries[ENTRIES];
+} Buffer;
+
+/* counters are only written by the owning thread, but may be read
+ * by others at the same time */
+#define INC(var, n) \
+	__atomic_store_n(&(var), (var) + (n), __ATOMIC_RELAXED)
+
+static Buffer *buffer_list;
+static __thread Buffer *buffer;
+
+static unsigned long long now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static Buffer *buffer_create(void)
+{
+	Buffer *o = calloc(1, sizeof(Buffer));
+	if (!o)
+		return 0;
+	o->next = __atomic_load_n(&buffer_list, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&buffer_list, &o->next, o, 1,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+	return buffer = o;
+}
+
+scoTraceSpan sco_trace_begin(const void *meta, unsigned int slot,
+		const char *name)
+{
+	scoTraceSpan span = {0, 0};
+	Buffer *b = buffer;
+	struct scoTraceEntry *e;
+	size_t i;
+	if (!b && !(b = buffer_create()))
+		return span;
+	i = (((size_t) meta >> 4) * 31 + slot) & (ENTRIES - 1);
+	for (;;) {
+		e = &b->entries[i];
+		if (e->meta == meta && e->slot == slot)
+			break;
+		if (!e->meta) {
+			if (b->used == ENTRIES_MAX) {
+				INC(b->lost, 1);
+				return span;
+			}
+			INC(b->used, 1);
+			e->slot = slot;
+			e->name = name;
+			__atomic_store_n(&e->meta, meta, __ATOMIC_RELEASE);
+			break;
+		}
+		i = (i + 1) & (ENTRIES - 1);
+	}
+	INC(e->calls, 1);
+	if (!(++b->count & (SCO_TRACE_PERIOD - 1))) {
+		span.entry = e;
+		span.start = now();
+	}
+	return span;
+}
+
+void sco_trace_end(scoTraceSpan *span)
+{
+	struct scoTraceEntry *e = span->entry;
+	if (e) {
+		unsigned long long t = now() - span->start;
+		INC(e->samples, 1);
+		INC(e->cycles, t);
+	}
+}
+
+/*
+ * Reporting.
+ */
+
+static int compare_key(const void *a, const void *b)
+{
+	const scoTraceStats *x = a, *y = b;
+	if (x->meta != y->meta)
+		return ((size_t) x->meta < (size_t) y->meta) ? -1 : 1;
+	return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+static double estimate(const scoTraceStats *o)
+{
+	return o->samples ? (double) o->cycles / o->samples * o->calls : 0;
+}
+
+static int compare_cost(const void *a, const void *b)
+{
+	double x = estimate(a), y = estimate(b);
+	return (x < y) - (x > y);
+}
+
+int sco_trace_walk(void (*func)(const scoTraceStats *stats, void *arg),
+		void *arg)
+{
+	const Buffer *b;
+	scoTraceStats *all;
+	size_t count = 0, merged = 0, i;
+	for (b = __atomic_load_n(&buffer_list, __ATOMIC_ACQUIRE); b;
+	     b = b->next)
+		count += __atomic_load_n(&b->used, __ATOMIC_RELAXED);
+	if (!count)
+		return 1;
+	if (!(all = malloc(count * sizeof(scoTraceStats))))
+		return 0;
+	for (b = __atomic_load_n(&buffer_list, __ATOMIC_ACQUIRE); b;
+	     b = b->next) {
+		for (i = 0; i < ENTRIES && merged < count; ++i) {
+			const struct scoTraceEntry *e = &b->entries[i];
+			scoTraceStats *s = &all[merged];
+			if (!(s->meta = __atomic_load_n(&e->meta,
+							__ATOMIC_ACQUIRE)))
+				continue;
+			s->class_name = ((const scoObject_Meta*)s->meta)->name;
+			s->method = e->name;
+			s->slot = e->slot;
+			s->calls = __atomic_load_n(&e->calls,
+					__ATOMIC_RELAXED);
+			s->samples = __atomic_load_n(&e->samples,
+					__ATOMIC_RELAXED);
+			s->cycles = __atomic_load_n(&e->cycles,
+					__ATOMIC_RELAXED);
+			++merged;
+		}
+	}
+	/* sum the counts of each thread */
+	qsort(all, merged, sizeof(scoTraceStats), compare_key);
+	for (count = 0, i = 0; i < merged; ++i) {
+		if (count && !compare_key(&all[count - 1], &all[i])) {
+			all[count - 1].calls += all[i].calls;
+			all[count - 1].samples += all[i].samples;
+			all[count - 1].cycles += all[i].cycles;
+		} else {
+			all[count++] = all[i];
+		}
+	}
+	qsort(all, count, sizeof(scoTraceStats), compare_cost);
+	for (i = 0; i < count; ++i)
+		func(&all[i], arg);
+	free(all);
+	return 1;
+}
+
+unsigned long long sco_trace_lost(void)
+{
+	const Buffer *b;
+	unsigned long long lost = 0;
+	for (b = __atomic_load_n(&buffer_list, __ATOMIC_ACQUIRE); b;
+	     b = b->next)
+		lost += __atomic_load_n(&b->lost, __ATOMIC_RELAXED);
+	return lost;
+}
+
+static void dump_method(const scoTraceStats *stats, void *out)
+{
+	fprintf(out, "%-24s %-20s %4u %14llu %10llu %12.1f\n",
+			stats->class_name, stats->method, stats->slot,
+			stats->calls, stats->samples,
+			stats->samples ?
+			(double)stats->cycles / stats->samples : 0.0);
+}
+
+void sco_trace_dump(FILE *out)
+{
+	fprintf(out, "%-24s %-20s %4s %14s %10s %12s\n",
+			"class", "method", "slot", "calls", "samples",
+			"cycles/call");
+	sco_trace_walk(dump_method, out);
+	if (sco_trace_lost())
+		fprintf(out, "(%llu calls lost)\n", sco_trace_lost());
+}
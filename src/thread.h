@@ -0,0 +1,185 @@
+/* SCOOP internal threading helpers
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCO_SRC_THREAD_H
+#define SCO_SRC_THREAD_H
+
+/*
+ * Spinlocks, threads, mutexes and thread-exit keys, as used within the
+ * library, for Windows and POSIX. Not part of the API.
+ */
+
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <sched.h>
+# include <unistd.h>
+#endif
+
+/* lets a thread waiting for another back off */
+static inline void backoff(void)
+{
+#ifdef WIN32
+	Sleep(0);
+#else
+	sched_yield();
+#endif
+}
+
+/* takes spinlock \p l, a zero'd byte when free */
+static inline void lock(unsigned char *l)
+{
+	while (__atomic_test_and_set(l, __ATOMIC_ACQUIRE))
+		backoff();
+}
+
+static inline void unlock(unsigned char *l)
+{
+	__atomic_clear(l, __ATOMIC_RELEASE);
+}
+
+/* gets the number of processors online, at least 1 */
+static inline unsigned int cpu_count(void)
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (unsigned int) n : 1;
+#endif
+}
+
+/*
+ * Threads, mutexes and condition variables. A thread function is
+ * declared as "static ThreadResult THREAD_CALL name(void *arg)", and
+ * returns 0.
+ */
+
+#ifdef WIN32
+typedef HANDLE Thread;
+typedef DWORD ThreadResult;
+# define THREAD_CALL WINAPI
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Cond;
+# define mutex_init(m) InitializeSRWLock(m)
+# define mutex_destroy(m) ((void)0)
+# define mutex_lock(m) AcquireSRWLockExclusive(m)
+# define mutex_unlock(m) ReleaseSRWLockExclusive(m)
+# define cond_init(c) InitializeConditionVariable(c)
+# define cond_destroy(c) ((void)0)
+# define cond_wait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+# define cond_signal(c) WakeConditionVariable(c)
+# define cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_t Thread;
+typedef void *ThreadResult;
+# define THREAD_CALL
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+# define mutex_init(m) pthread_mutex_init(m, 0)
+# define mutex_destroy(m) pthread_mutex_destroy(m)
+# define mutex_lock(m) pthread_mutex_lock(m)
+# define mutex_unlock(m) pthread_mutex_unlock(m)
+# define cond_init(c) pthread_cond_init(c, 0)
+# define cond_destroy(c) pthread_cond_destroy(c)
+# define cond_wait(c, m) pthread_cond_wait(c, m)
+# define cond_signal(c) pthread_cond_signal(c)
+# define cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+/* starts \p func with \p arg in thread \p t, returning zero on failure */
+static inline int thread_create(Thread *t,
+		ThreadResult (THREAD_CALL *func)(void*), void *arg)
+{
+#ifdef WIN32
+	return (*t = CreateThread(0, 0, func, arg, 0, 0)) != 0;
+#else
+	return !pthread_create(t, 0, func, arg);
+#endif
+}
+
+static inline void thread_join(Thread t)
+{
+#ifdef WIN32
+	WaitForSingleObject(t, INFINITE);
+	CloseHandle(t);
+#else
+	pthread_join(t, 0);
+#endif
+}
+
+/*
+ * Thread-exit keys. A key holds a value for each thread, which is passed
+ * to the exit function of the key when the thread exits, if not NULL.
+ * An exit function is declared as "static void EXIT_CALL name(void*)".
+ * A key is made on first use, and should be zero-initialized.
+ */
+
+#ifdef WIN32
+# define EXIT_CALL WINAPI
+#else
+# define EXIT_CALL
+#endif
+
+typedef struct ThreadKey {
+	unsigned char lock;
+	int state; /* 1 once the key is made, -1 if that failed */
+#ifdef WIN32
+	DWORD key;
+#else
+	pthread_key_t key;
+#endif
+} ThreadKey;
+
+/* makes key \p k with \p exit unless done before, returning zero if
+ * the key could not be made */
+static inline int thread_key_make(ThreadKey *k, void (EXIT_CALL *exit)(void*))
+{
+	lock(&k->lock);
+	if (!k->state) {
+#ifdef WIN32
+		k->key = FlsAlloc(exit);
+		k->state = (k->key != FLS_OUT_OF_INDEXES) ? 1 : -1;
+#else
+		k->state = !pthread_key_create(&k->key, exit) ? 1 : -1;
+#endif
+	}
+	unlock(&k->lock);
+	return k->state > 0;
+}
+
+/* sets the value of made key \p k for the calling thread, returning
+ * zero on failure */
+static inline int thread_key_set(ThreadKey *k, void *value)
+{
+#ifdef WIN32
+	return FlsSetValue(k->key, value) != 0;
+#else
+	return !pthread_setspecific(k->key, value);
+#endif
+}
+
+#endif /* SCO_SRC_THREAD_H */
@@ -0,0 +1,181 @@
+/* Simple test program for the SCOOP Actor module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Actor.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#define ACTORS 8
+#define SENDERS 4
+#define MESSAGES 10000 /* per sender and actor */
+
+/*
+ * Counters, adding without atomics, so that messages run in parallel
+ * for one actor would lose counts. Each also checks that the messages
+ * from each sender arrive in the order sent.
+ */
+
+struct step {
+	int sender;
+	int seq;
+};
+
+#define Counter_ scoActor_ \
+	long count; \
+	int last[SENDERS]; \
+	int disorder;
+#define Counter__ scoActor__ \
+	void (*add)(void *o, void *arg); \
+	void (*step)(void *o, void *arg); \
+	void (*relay)(void *o, void *arg);
+_SCOclassdef(Counter);
+
+static void Counter_add(void *_o, void *arg)
+{
+	Counter *o = _o;
+	o->count += (long) arg;
+}
+
+static void Counter_step(void *_o, void *arg)
+{
+	Counter *o = _o;
+	const struct step *s = arg;
+	if (s->seq != o->last[s->sender] + 1)
+		++o->disorder;
+	o->last[s->sender] = s->seq;
+	++o->count;
+}
+
+/* counts, and sends on to the actor given */
+static void Counter_relay(void *_o, void *arg)
+{
+	Counter *o = _o, *next = arg;
+	++o->count;
+	if (next)
+		sco_send(add, next, (void*) 1L);
+}
+
+static void Counter_vtinit(Counter_Meta *o)
+{
+	Counter_Virt *vt = &o->virt;
+	vt->add = Counter_add;
+	vt->step = Counter_step;
+	vt->relay = Counter_relay;
+}
+_SCOmetainst(Counter, scoActor, 0, Counter_vtinit);
+
+_SCOctordef(Counter, Counter,, (Counter *o, scoWorkers *workers),
+		(o, workers))
+{
+	int i;
+	if (!sco_Actor_ctor((scoActor*)o, workers))
+		return 0;
+	for (i = 0; i < SENDERS; ++i)
+		o->last[i] = -1;
+	return 1;
+}
+
+static Counter *actors[ACTORS];
+
+static void *send_steps(void *arg)
+{
+	struct step s;
+	int i, j;
+	s.sender = (int) (long) arg;
+	for (i = 0; i < MESSAGES; ++i) {
+		s.seq = i;
+		for (j = 0; j < ACTORS; ++j)
+			if (!sco_send_copy(step, actors[j], &s, sizeof(s)))
+				return (void*) 1L;
+	}
+	return 0;
+}
+
+int main()
+{
+	pthread_t thread[SENDERS];
+	scoWorkers *workers = sco_workers_create(4);
+	int ok = workers != 0, i;
+	long total = 0;
+	static const long big[SCO_MESSAGE_DATA + 1];
+
+	if (!ok) {
+		puts("actor test FAILED");
+		return 1;
+	}
+	for (i = 0; i < ACTORS; ++i)
+		actors[i] = Counter_new(0, workers);
+
+	/* Messages from several threads run one at a time per actor, and
+	 * in order per sender.
+	 */
+	for (i = 0; i < SENDERS; ++i)
+		pthread_create(&thread[i], 0, send_steps, (void*) (long) i);
+	for (i = 0; i < SENDERS; ++i) {
+		void *failed;
+		pthread_join(thread[i], &failed);
+		if (failed)
+			ok = 0;
+	}
+	sco_workers_wait(workers);
+	for (i = 0; i < ACTORS; ++i) {
+		if (actors[i]->count != (long) SENDERS * MESSAGES ||
+		    actors[i]->disorder)
+			ok = 0;
+		total += actors[i]->count;
+	}
+
+	/* Handlers may send messages, which wait also waits for.
+	 */
+	for (i = 0; i < ACTORS; ++i)
+		actors[i]->count = 0;
+	for (i = 0; i < MESSAGES; ++i)
+		sco_send(relay, actors[i % ACTORS],
+				actors[(i + 1) % ACTORS]);
+	sco_workers_wait(workers);
+	for (i = 0; i < ACTORS; ++i)
+		if (actors[i]->count != 2L * MESSAGES / ACTORS)
+			ok = 0;
+
+	/* Data too large to copy is refused.
+	 */
+	if (sco_send_copy(step, actors[0], big, sizeof(big)))
+		ok = 0;
+
+	/* Destroying the pool runs what is pending.
+	 */
+	for (i = 0; i < ACTORS; ++i)
+		actors[i]->count = 0;
+	for (i = 0; i < MESSAGES; ++i)
+		sco_send(add, actors[i % ACTORS], (void*) 2L);
+	sco_workers_destroy(workers);
+	for (i = 0; i < ACTORS; ++i) {
+		if (actors[i]->count != 2L * MESSAGES / ACTORS)
+			ok = 0;
+		sco_delete(actors[i]);
+	}
+
+	printf("%ld messages counted\n", total);
+	puts(ok ? "actor test ok" : "actor test FAILED");
+	return !ok;
+}
@@ -0,0 +1,170 @@
+/* Simple test program for the SCOOP Arena module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Object-ExtendedThing.h"
+#include <scoop/Arena.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * A class with a destructor, counting destroyed instances.
+ */
+
+#define Node_ scoExtendedThing_ \
+	struct Node *next;
+#define Node__ scoExtendedThing__
+_SCOclassdef(Node);
+
+static int dtor_count;
+
+static void Node_dtor(Node *o)
+{
+	(void)o;
+	++dtor_count;
+}
+
+_SCOmetainst(Node, scoExtendedThing, Node_dtor, 0);
+_SCOctordef(Node, Node,, (Node *o, Node *next), (o, next))
+{
+	sco_ExtendedThing_ctor(o);
+	o->next = next;
+	return 1;
+}
+
+/*
+ * A class isolated in cache lines.
+ */
+
+#define Counter_ long count;
+#define Counter__
+_SCOclassdef(Counter);
+_SCOmetainst(Counter, scoNone, 0, 0, SCO_CACHELINE);
+
+/*
+ * A tracked class, whose instances are listed from creation.
+ */
+
+#define Item_ scoTracked_ \
+	int value;
+#define Item__
+_SCOclassdef(Item);
+
+static int item_dtor_count;
+
+static void Item_dtor(Item *o)
+{
+	(void)o;
+	++item_dtor_count;
+}
+
+_SCOmetainst(Item, scoNone, Item_dtor, 0, SCO_TRACK);
+_SCOctordef(Item, Item,, (Item *o, int value), (o, value))
+{
+	o->value = value;
+	return 1;
+}
+
+static int item_clean_count;
+
+static void Item_clean(void *o)
+{
+	++item_clean_count;
+	sco_delete(o);
+}
+
+#define NODES 100000
+
+int main()
+{
+	scoArena *arena = sco_arena_create(0);
+	Node *list = 0, *node;
+	scoThing *thing;
+	Counter *counter;
+	int i, count, ok = 1;
+
+	/* Build a list of nodes, and an instance without destructors.
+	 */
+	for (i = 0; i < NODES; ++i)
+		list = Node_new(sco_arena_raw_new(arena, sco_metaof(Node)),
+				list);
+	thing = sco_Thing_new(sco_arena_raw_new(arena, sco_metaof(scoThing)));
+	if (!list || !thing) {
+		puts("allocation in arena failed");
+		return 1;
+	}
+
+	/* RTTI and virtual functions work as usual.
+	 */
+	if (!sco_of_subclass(list, scoThing) || !sco_of_class(thing, scoThing))
+		ok = 0;
+	sco_virt(do_foo, list);
+	sco_virt(do_foo, thing);
+	for (count = 0, node = list; node; node = node->next)
+		if (node->y == 42.f) ++count;
+	if (count != NODES)
+		ok = 0;
+
+	/* Destroying one node early keeps it from being destroyed again.
+	 */
+	sco_finalize(list);
+	sco_arena_clear(arena);
+	if (dtor_count != NODES)
+		ok = 0;
+	printf("%d nodes destroyed with arena\n", dtor_count);
+
+	/* Aligned instances among other allocations.
+	 */
+	for (i = 0; i < 100; ++i) {
+		sco_arena_alloc(arena, 24);
+		counter = sco_arena_raw_new(arena, sco_metaof(Counter));
+		if (!counter || (uintptr_t)counter % SCO_CACHE_LINE)
+			ok = 0;
+	}
+
+	/* Tracked instances are listed once, and unlisted with the arena.
+	 */
+	for (i = 0; i < 100; ++i)
+		if (!Item_new(sco_arena_raw_new(arena, sco_metaof(Item)), i))
+			ok = 0;
+	if (!Item_new(0, -1))
+		ok = 0;
+	sco_arena_clear(arena);
+	if (item_dtor_count != 100)
+		ok = 0;
+	sco_clean(sco_metaof(Item), Item_clean);
+	if (item_clean_count != 1 || item_dtor_count != 101)
+		ok = 0;
+
+	/* Reuse the arena after clearing it.
+	 */
+	dtor_count = 0;
+	list = Node_new(sco_arena_raw_new(arena, sco_metaof(Node)), 0);
+	if (!sco_arena_alloc(arena, 1 << 20))
+		ok = 0;
+	sco_arena_destroy(arena);
+	if (dtor_count != 1)
+		ok = 0;
+
+	puts(ok ? "arena test ok" : "arena test FAILED");
+	return !ok;
+}
@@ -0,0 +1,138 @@
+/* Test program for the SCOOP CPU module, running itself at each feature
+ * level
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/CPU.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N 1000
+
+/*
+ * A class with a static virtual function in several versions, which
+ * each note their name when called.
+ */
+
+#define Vec_
+#define Vec__ float (*sum)(const float *v, size_t n);
+_SCOclassdef(Vec);
+
+static const char *variant;
+
+#define SUMDEF(name) \
+static float Vec_sum_##name(const float *v, size_t n) \
+{ \
+	float sum = 0.f; \
+	size_t i; \
+	for (i = 0; i < n; ++i) \
+		sum += v[i]; \
+	variant = #name; \
+	return sum; \
+}
+
+SUMDEF(generic)
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2"))) SUMDEF(sse2)
+__attribute__((target("avx2"))) SUMDEF(avx2)
+__attribute__((target("avx512f"))) SUMDEF(avx512f)
+#endif
+
+static const scoCPUImpl sum_impls[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{SCO_CPU_AVX512F, (scoCPUFunc) Vec_sum_avx512f},
+	{SCO_CPU_AVX2, (scoCPUFunc) Vec_sum_avx2},
+	{SCO_CPU_SSE2, (scoCPUFunc) Vec_sum_sse2},
+#endif
+	{0, (scoCPUFunc) Vec_sum_generic},
+};
+
+static const char *const sum_names[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	"avx512f", "avx2", "sse2",
+#endif
+	"generic"
+};
+
+static void Vec_vtinit(Vec_Meta *o)
+{
+	sco_cpu_pick(o->virt.sum, sum_impls);
+}
+
+_SCOmetainst(Vec, scoNone, 0, Vec_vtinit);
+
+/* the levels to run at, and the features each allows */
+static const struct {
+	const char *name;
+	unsigned int mask;
+} levels[] = {
+	{"none", 0},
+	{"sse2", SCO_CPU_SSE2},
+	{"avx2", SCO_CPU_SSE2 | SCO_CPU_SSE4_2 | SCO_CPU_AVX | SCO_CPU_AVX2},
+	{"avx512f", ~0U},
+};
+
+/* run at the level given by SCO_CPU, printing the version used */
+static int child(void)
+{
+	float v[N];
+	Vec *vec = sco_raw_new(0, sco_metaof(Vec));
+	int i;
+	for (i = 0; i < N; ++i)
+		v[i] = (float) i;
+	if (sco_svirt(sum, vec, v, N) != (float) (N * (N - 1) / 2))
+		variant = "bad sum";
+	puts(variant);
+	sco_delete(vec);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int host = sco_cpu_features();
+	size_t i;
+	int ok = 1;
+	if (argc > 1)
+		return child();
+	for (i = 0; i < sizeof(levels) / sizeof(*levels); ++i) {
+		unsigned int features = host & levels[i].mask;
+		const scoCPUImpl *impl = sum_impls;
+		char cmd[256], out[64] = "";
+		FILE *pipe;
+		/* find the expected version, and the one used */
+		while ((impl->features & features) != impl->features)
+			++impl;
+		snprintf(cmd, sizeof(cmd), "SCO_CPU=%s %s child",
+				levels[i].name, argv[0]);
+		if (!(pipe = popen(cmd, "r")) || !fgets(out, sizeof(out), pipe))
+			ok = 0;
+		if (pipe)
+			pclose(pipe);
+		out[strcspn(out, "\n")] = '\0';
+		printf("level %s: %s version used\n", levels[i].name, out);
+		if (strcmp(out, sum_names[impl - sum_impls]))
+			ok = 0;
+	}
+	puts(ok ? "CPU test ok" : "CPU test FAILED");
+	return !ok;
+}
@@ -0,0 +1,153 @@
+/* Simple test program for the SCOOP Epoch module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Epoch.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#define READERS 3
+#define SLOTS 16
+#define REPLACEMENTS 20000
+
+/*
+ * Nodes which are replaced in a table while readers look at them,
+ * their destructor marking them dead so that a reader would notice.
+ */
+
+#define Node_ int value;
+#define Node__
+_SCOclassdef(Node);
+
+static int deleted;
+
+static void Node_dtor(Node *o)
+{
+	o->value = -1;
+	__atomic_add_fetch(&deleted, 1, __ATOMIC_RELAXED);
+}
+_SCOmetainst(Node, scoNone, Node_dtor, 0);
+
+_SCOctordef(Node, Node,, (Node *o, int value), (o, value))
+{
+	o->value = value;
+	return 1;
+}
+
+static Node *table[SLOTS];
+static int stop, in_section, leave_section, bad_reads;
+
+static int deleted_count(void)
+{
+	return __atomic_load_n(&deleted, __ATOMIC_RELAXED);
+}
+
+/* stays in a read section until told to leave */
+static void *hold_section(void *arg)
+{
+	(void) arg;
+	sco_epoch_register();
+	sco_epoch_enter();
+	__atomic_store_n(&in_section, 1, __ATOMIC_RELEASE);
+	while (!__atomic_load_n(&leave_section, __ATOMIC_ACQUIRE))
+		sched_yield();
+	sco_epoch_exit();
+	sco_epoch_unregister();
+	return 0;
+}
+
+static void *read_table(void *arg)
+{
+	int i = 0;
+	(void) arg;
+	sco_epoch_register();
+	while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+		Node *node;
+		sco_epoch_enter();
+		node = __atomic_load_n(&table[i++ % SLOTS], __ATOMIC_ACQUIRE);
+		sched_yield();
+		if (node->value < 0)
+			__atomic_add_fetch(&bad_reads, 1, __ATOMIC_RELAXED);
+		sco_epoch_exit();
+	}
+	sco_epoch_unregister();
+	return 0;
+}
+
+int main()
+{
+	pthread_t thread[READERS];
+	Node *node;
+	int ok = 1, i;
+
+	/* Retired objects outlive read sections begun before.
+	 */
+	pthread_create(&thread[0], 0, hold_section, 0);
+	while (!__atomic_load_n(&in_section, __ATOMIC_ACQUIRE))
+		sched_yield();
+	for (i = 0; i < 10; ++i)
+		if (!sco_retire(Node_new(0, i)))
+			ok = 0;
+	sco_epoch_reclaim();
+	if (deleted_count() != 0)
+		ok = 0;
+	__atomic_store_n(&leave_section, 1, __ATOMIC_RELEASE);
+	pthread_join(thread[0], 0);
+	sco_epoch_sync();
+	if (deleted_count() != 10)
+		ok = 0;
+
+	/* Nodes replaced while being read are not deleted under readers.
+	 */
+	for (i = 0; i < SLOTS; ++i)
+		table[i] = Node_new(0, i);
+	for (i = 0; i < READERS; ++i)
+		pthread_create(&thread[i], 0, read_table, 0);
+	for (i = 0; i < REPLACEMENTS; ++i) {
+		Node *old = table[i % SLOTS];
+		__atomic_store_n(&table[i % SLOTS], Node_new(0, i),
+				__ATOMIC_RELEASE);
+		if (!sco_retire(old))
+			ok = 0;
+	}
+	__atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < READERS; ++i)
+		pthread_join(thread[i], 0);
+	sco_epoch_sync();
+	if (bad_reads || deleted_count() != 10 + REPLACEMENTS)
+		ok = 0;
+	for (i = 0; i < SLOTS; ++i)
+		sco_delete(table[i]);
+
+	/* A thread need not be registered to retire, nor to sync.
+	 */
+	node = Node_new(0, 0);
+	sco_retire(node);
+	sco_epoch_sync();
+	if (deleted_count() != 11 + REPLACEMENTS + SLOTS)
+		ok = 0;
+
+	printf("%d objects deleted\n", deleted_count());
+	puts(ok ? "epoch test ok" : "epoch test FAILED");
+	return !ok;
+}
@@ -0,0 +1,198 @@
+/* Simple test program for the SCOOP Iface module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Iface.h>
+#include <stdio.h>
+
+#define MANY 40
+
+/*
+ * Two interfaces, implemented by unrelated classes: Circle is Drawable,
+ * Square is Drawable and Hashable, and Tag only Hashable. Subsquare
+ * inherits both from Square, overriding Hashable. Plain has none.
+ */
+
+#define Drawable__ int (*draw)(void *o);
+_SCOifacedef(Drawable);
+
+#define Hashable__ unsigned int (*hash)(const void *o);
+_SCOifacedef(Hashable);
+
+#define Shape_ int size;
+#define Shape__
+_SCOclassdef(Shape);
+_SCOmetainst(Shape, scoNone, 0, 0);
+
+static int Circle_draw(void *o) { return 1000 + ((Shape*)o)->size; }
+
+static const Drawable_Iface Circle_drawable = {Circle_draw};
+static const scoImpl Circle_impls[] = {
+	SCO_IMPL(Drawable, &Circle_drawable),
+	SCO_IMPL_END
+};
+
+#define Circle_ Shape_
+#define Circle__ Shape__
+_SCOclassdef(Circle);
+static void Circle_vtinit(Circle_Meta *o) { o->impls = Circle_impls; }
+_SCOmetainst(Circle, Shape, 0, Circle_vtinit);
+
+static int Square_draw(void *o) { return 2000 + ((Shape*)o)->size; }
+static unsigned int Square_hash(const void *o)
+{
+	return 2 * ((const Shape*)o)->size;
+}
+
+static const Drawable_Iface Square_drawable = {Square_draw};
+static const Hashable_Iface Square_hashable = {Square_hash};
+static const scoImpl Square_impls[] = {
+	SCO_IMPL(Drawable, &Square_drawable),
+	SCO_IMPL(Hashable, &Square_hashable),
+	SCO_IMPL_END
+};
+
+#define Square_ Shape_
+#define Square__ Shape__
+_SCOclassdef(Square);
+static void Square_vtinit(Square_Meta *o) { o->impls = Square_impls; }
+_SCOmetainst(Square, Shape, 0, Square_vtinit);
+
+static unsigned int Subsquare_hash(const void *o)
+{
+	return 3 * ((const Shape*)o)->size;
+}
+
+static const Hashable_Iface Subsquare_hashable = {Subsquare_hash};
+static const scoImpl Subsquare_impls[] = {
+	SCO_IMPL(Hashable, &Subsquare_hashable),
+	SCO_IMPL_END
+};
+
+#define Subsquare_ Square_
+#define Subsquare__ Square__
+_SCOclassdef(Subsquare);
+static void Subsquare_vtinit(Subsquare_Meta *o)
+{
+	o->impls = Subsquare_impls;
+}
+_SCOmetainst(Subsquare, Square, 0, Subsquare_vtinit);
+
+#define Tag_ char name[8];
+#define Tag__
+_SCOclassdef(Tag);
+static unsigned int Tag_hash(const void *o)
+{
+	return ((const Tag*)o)->name[0];
+}
+static const Hashable_Iface Tag_hashable = {Tag_hash};
+static const scoImpl Tag_impls[] = {
+	SCO_IMPL(Hashable, &Tag_hashable),
+	SCO_IMPL_END
+};
+static void Tag_vtinit(Tag_Meta *o) { o->impls = Tag_impls; }
+_SCOmetainst(Tag, scoNone, 0, Tag_vtinit);
+
+/* a class implementing many interfaces, all with the same table */
+#define Many_ int size;
+#define Many__
+_SCOclassdef(Many);
+_SCOmetainst(Many, scoNone, 0, 0);
+static scoIface many_ifaces[MANY];
+static scoImpl many_impls[MANY + 1];
+
+static int draw_all(void **objs, int n)
+{
+	int sum = 0, i;
+	for (i = 0; i < n; ++i) {
+		const Drawable_Iface *d = sco_iface(objs[i], Drawable);
+		if (d) sum += d->draw(objs[i]);
+	}
+	return sum;
+}
+
+static unsigned int hash_all(void **objs, int n)
+{
+	unsigned int sum = 0;
+	int i;
+	for (i = 0; i < n; ++i) {
+		const Hashable_Iface *h = sco_iface(objs[i], Hashable);
+		if (h) sum += h->hash(objs[i]);
+	}
+	return sum;
+}
+
+int main()
+{
+	void *objs[5];
+	Tag *tag;
+	Many *many;
+	int ok = 1, i;
+
+	objs[0] = sco_raw_new(0, sco_metaof(Circle));
+	objs[1] = sco_raw_new(0, sco_metaof(Square));
+	objs[2] = sco_raw_new(0, sco_metaof(Subsquare));
+	objs[3] = tag = sco_raw_new(0, sco_metaof(Tag));
+	objs[4] = sco_raw_new(0, sco_metaof(Shape));
+	for (i = 0; i < 5; ++i)
+		if (i != 3) ((Shape*)objs[i])->size = i + 1;
+	tag->name[0] = 'a';
+
+	/* Lookups find the table of the class, or the inherited one.
+	 */
+	if (sco_iface_get(objs[0], sco_ifaceof(Drawable)) != &Circle_drawable ||
+	    sco_iface_get(objs[0], sco_ifaceof(Hashable)) ||
+	    sco_iface_get(objs[2], sco_ifaceof(Drawable)) != &Square_drawable ||
+	    sco_iface_get(objs[2], sco_ifaceof(Hashable)) !=
+			&Subsquare_hashable ||
+	    sco_iface_get(objs[4], sco_ifaceof(Drawable)))
+		ok = 0;
+
+	/* Cached lookups at a call site, for mixed and repeated classes.
+	 */
+	for (i = 0; i < 3; ++i)
+		if (draw_all(objs, 5) != 1001 + 2002 + 2003 ||
+		    hash_all(objs, 5) != 4 + 9 + 'a' ||
+		    draw_all(objs + 1, 1) != 2002)
+			ok = 0;
+
+	/* Many interfaces get an entry each.
+	 */
+	for (i = 0; i < MANY; ++i) {
+		many_ifaces[i].name = "Many";
+		many_impls[i].iface = &many_ifaces[i];
+		many_impls[i].table = &many_ifaces[i];
+	}
+	sco_metaof(Many)->impls = many_impls;
+	many = sco_raw_new(0, sco_metaof(Many));
+	for (i = 0; i < MANY; ++i)
+		if (sco_iface_get(many, &many_ifaces[i]) != &many_ifaces[i])
+			ok = 0;
+	if (sco_iface_get(many, sco_ifaceof(Drawable)))
+		ok = 0;
+
+	for (i = 0; i < 5; ++i)
+		sco_delete(objs[i]);
+	sco_delete(many);
+	puts(ok ? "interface test ok" : "interface test FAILED");
+	return !ok;
+}
@@ -0,0 +1,179 @@
+/* Stress test for the SCOOP Object module - meta type initialization
+ * from many threads at once
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Registry.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdio.h>
+
+#define THREADS 16
+#define ROUNDS 500
+
+/*
+ * A deep hierarchy, Level0 - Level7, where each level adds a virtual
+ * function returning its level, and overrides level() to return it too.
+ * Two sibling leaves, Level7a and Level7b, share Level6 as superclass.
+ */
+
+#define Level0_ int v0;
+#define Level0__ int (*level)(void *o); int (*f0)(void *o);
+#define Level1_ Level0_ int v1;
+#define Level1__ Level0__ int (*f1)(void *o);
+#define Level2_ Level1_ int v2;
+#define Level2__ Level1__ int (*f2)(void *o);
+#define Level3_ Level2_ int v3;
+#define Level3__ Level2__ int (*f3)(void *o);
+#define Level4_ Level3_ int v4;
+#define Level4__ Level3__ int (*f4)(void *o);
+#define Level5_ Level4_ int v5;
+#define Level5__ Level4__ int (*f5)(void *o);
+#define Level6_ Level5_ int v6;
+#define Level6__ Level5__ int (*f6)(void *o);
+#define Level7a_ Level6_ int v7;
+#define Level7a__ Level6__ int (*f7)(void *o);
+#define Level7b_ Level6_ int v7;
+#define Level7b__ Level6__ int (*f7)(void *o);
+
+_SCOclassdef(Level0);
+_SCOclassdef(Level1);
+_SCOclassdef(Level2);
+_SCOclassdef(Level3);
+_SCOclassdef(Level4);
+_SCOclassdef(Level5);
+_SCOclassdef(Level6);
+_SCOclassdef(Level7a);
+_SCOclassdef(Level7b);
+
+#define LEVELDEF(Class, Superclass, n) \
+static int Class##_f(void *o) { (void)o; return n; } \
+static void Class##_vtinit(Class##_Meta *o) \
+{ \
+	o->virt.level = Class##_f; \
+	o->virt.f##n = Class##_f; \
+} \
+_SCOmetainst(Class, Superclass, 0, Class##_vtinit)
+
+LEVELDEF(Level0, scoNone, 0);
+LEVELDEF(Level1, Level0, 1);
+LEVELDEF(Level2, Level1, 2);
+LEVELDEF(Level3, Level2, 3);
+LEVELDEF(Level4, Level3, 4);
+LEVELDEF(Level5, Level4, 5);
+LEVELDEF(Level6, Level5, 6);
+LEVELDEF(Level7a, Level6, 7);
+LEVELDEF(Level7b, Level6, 7);
+
+/* meta types in superclass order, and copies of them as never used */
+#define METAOF(Class) \
+	{(scoObject_Meta*)sco_metaof(Class), sizeof(Class##_Meta)}
+static const struct {
+	scoObject_Meta *meta;
+	size_t size;
+} metas[] = {
+	METAOF(Level0),
+	METAOF(Level1),
+	METAOF(Level2),
+	METAOF(Level3),
+	METAOF(Level4),
+	METAOF(Level5),
+	METAOF(Level6),
+	METAOF(Level7a),
+	METAOF(Level7b),
+};
+#define METAS (sizeof(metas) / sizeof(*metas))
+static Level7a_Meta pristine[METAS];
+
+static pthread_barrier_t barrier;
+static int failures;
+
+/* checks that every virtual function of \p o is that of the right level;
+ * after the dtor come level() and then f0() - f7() as far as defined */
+static int check(scoObject *o, int depth)
+{
+	int (*const *vt)(void *o) = (int (*const *)(void*)) &o->meta->virt;
+	int i;
+	if (vt[1](o) != depth)
+		return 0;
+	for (i = 0; i <= depth; ++i)
+		if (vt[2 + i](o) != i)
+			return 0;
+	return 1;
+}
+
+static void *worker(void *arg)
+{
+	int id = (int) (size_t) arg, round;
+	for (round = 0; round < ROUNDS; ++round) {
+		/* spread threads over leaves and the levels above them */
+		int depth = 7 - (id + round) % 4;
+		scoObject_Meta *meta = metas[depth == 7 ?
+			7 + (id & 1) : depth].meta;
+		void *o;
+		pthread_barrier_wait(&barrier);
+		if (!(o = sco_raw_new(0, meta)) || !check(o, depth))
+			__atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+		sco_delete(o);
+		pthread_barrier_wait(&barrier);
+	}
+	return 0;
+}
+
+int main()
+{
+	pthread_t threads[THREADS];
+	size_t i;
+	for (i = 0; i < METAS; ++i)
+		memcpy(&pristine[i], metas[i].meta, metas[i].size);
+	pthread_barrier_init(&barrier, 0, THREADS + 1);
+	for (i = 0; i < THREADS; ++i)
+		pthread_create(&threads[i], 0, worker, (void*) i);
+	for (i = 0; i < ROUNDS; ++i) {
+		size_t j;
+		/* make every meta type uninitialized again for the round,
+		 * keeping the counters made once for it (if SCO_STATS) */
+		for (j = 0; j < METAS; ++j) {
+			struct scoStats *stats = metas[j].meta->stats;
+			memcpy(metas[j].meta, &pristine[j], metas[j].size);
+			metas[j].meta->stats = stats;
+		}
+		pthread_barrier_wait(&barrier);
+		pthread_barrier_wait(&barrier);
+	}
+	for (i = 0; i < THREADS; ++i)
+		pthread_join(threads[i], 0);
+	pthread_barrier_destroy(&barrier);
+	if (failures) {
+		printf("%d of %d first allocations got a bad meta type\n",
+				failures, THREADS * ROUNDS);
+		return 1;
+	}
+	if (sco_class_count() != METAS) {
+		printf("%u classes registered for %d\n",
+				sco_class_count(), (int) METAS);
+		return 1;
+	}
+	printf("%d rounds of %d threads racing to initialize ok\n",
+			ROUNDS, THREADS);
+	return 0;
+}
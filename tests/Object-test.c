@@ -22,7 +22,11 @@
  */
 
 #include "Object-ExtendedThing.h"
+#include <setjmp.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * Adding an extra type here with no exported symbols...
@@ -47,7 +51,7 @@ static void StaticThing_virtinit(StaticThing_Meta *o)
 }
 
 _SCOmetainst(StaticThing, scoExtendedThing,
-		StaticThing_dtor, StaticThing_virtinit);
+		StaticThing_dtor, StaticThing_virtinit, SCO_FINAL);
 _SCOctordec(StaticThing, StaticThing,, (StaticThing *o)); /* optional here */
 _SCOctordef(StaticThing, StaticThing,, (StaticThing *o), (o)) {
 	sco_ExtendedThing_ctor(o);
@@ -56,27 +60,277 @@ _SCOctordef(StaticThing, StaticThing,, (StaticThing *o), (o)) {
 
 static StaticThing sthing; /* let's make it global, too */
 
+/*
+ * And a class trying to derive from the final StaticThing.
+ */
+
+#define NotThing_ StaticThing_
+#define NotThing__ StaticThing__
+_SCOclassdef(NotThing);
+_SCOmetainst(NotThing, StaticThing, 0, 0);
+
+/*
+ * A tracked class, and a subclass of it, which is tracked too. They
+ * have virtual variables, one of which the subclass overrides, and
+ * one of which is left unset, and so zero.
+ */
+
+#define Tracked_ scoTracked_ int id;
+#define Tracked__
+#define Tracked___ const char *kind; int limit;
+_SCOvvclassdef(Tracked);
+
+#define SubTracked_ Tracked_
+#define SubTracked__ Tracked__
+#define SubTracked___ Tracked___
+_SCOvvclassdef(SubTracked);
+static SubTracked_Meta _SubTracked_meta;
+
+static int tracked_checked; /* RTTI checks made during init */
+static int subtracked_checked;
+
+static int tracked_order = 1; /* set to 0 if destroyed out of order */
+static int last_id;
+
+static void Tracked_dtor(Tracked *o)
+{
+	if (o->id < last_id) tracked_order = 0;
+	last_id = o->id;
+}
+
+static void Tracked_vtinit(Tracked_Meta *o)
+{
+	o->vars.kind = "tracked";
+	tracked_checked = sco_rtticheck(sco_metaof(SubTracked), o);
+}
+
+_SCOmetainst(Tracked, scoNone, Tracked_dtor, Tracked_vtinit, SCO_TRACK);
+_SCOctordef(Tracked, Tracked,, (Tracked *o, int id), (o, id)) {
+	o->id = id;
+	return 1;
+}
+
+static void SubTracked_vtinit(SubTracked_Meta *o)
+{
+	o->vars.kind = "subtracked";
+	subtracked_checked = sco_rtticheck(o, sco_metaof(Tracked));
+}
+
+_SCOmetainst(SubTracked, Tracked, 0, SubTracked_vtinit);
+_SCOctordef(SubTracked, SubTracked,, (SubTracked *o, int id), (o, id)) {
+	return Tracked_ctor((Tracked*)o, id);
+}
+
+/*
+ * A class constructed from a prototype, with a default constructor
+ * run once for it, and a constructor setting only the id.
+ */
+
+#define Proto_ int id; int weights[8]; const char *label;
+#define Proto__
+_SCOclassdef(Proto);
+
+static int proto_defaults_calls;
+
+static unsigned char Proto_defaults(Proto *o)
+{
+	int i;
+	for (i = 0; i < 8; ++i)
+		o->weights[i] = i * i;
+	o->label = "proto";
+	++proto_defaults_calls;
+	return 1;
+}
+
+_SCOmetainst(Proto, scoNone, 0, 0, SCO_POOL);
+_SCOctordef(Proto, Proto,, (Proto *o, int id), (o, id)) {
+	o->id = id;
+	return 1;
+}
+
+/*
+ * A class owning a string, deep-copied by its copy hook, and
+ * a subclass with a copy hook of its own.
+ */
+
+#define Buffer_ char *text;
+#define Buffer__
+_SCOclassdef(Buffer);
+
+static int copy_order; /* counts copy hook calls, base class first */
+
+static void Buffer_dtor(Buffer *o)
+{
+	free(o->text);
+}
+
+static unsigned char Buffer_copy(Buffer *o, const Buffer *src)
+{
+	if (copy_order++ != 0)
+		return 0;
+	return (o->text = strdup(src->text)) != 0;
+}
+
+static void Buffer_vtinit(Buffer_Meta *o)
+{
+	o->copy = (scoCopy)Buffer_copy;
+}
+
+_SCOmetainst(Buffer, scoNone, Buffer_dtor, Buffer_vtinit);
+_SCOctordef(Buffer, Buffer,, (Buffer *o, const char *text), (o, text)) {
+	return (o->text = strdup(text)) != 0;
+}
+
+#define SubBuffer_ Buffer_ int copies;
+#define SubBuffer__ Buffer__
+_SCOclassdef(SubBuffer);
+
+static unsigned char SubBuffer_copy(SubBuffer *o, const SubBuffer *src)
+{
+	if (copy_order++ != 1)
+		return 0;
+	o->copies = src->copies + 1;
+	return 1;
+}
+
+static void SubBuffer_vtinit(SubBuffer_Meta *o)
+{
+	o->copy = (scoCopy)SubBuffer_copy;
+}
+
+_SCOmetainst(SubBuffer, Buffer, 0, SubBuffer_vtinit);
+_SCOctordef(SubBuffer, SubBuffer,, (SubBuffer *o, const char *text),
+		(o, text)) {
+	return Buffer_ctor((Buffer*)o, text);
+}
+
+/*
+ * A class needing more alignment than malloc() gives, and a class
+ * isolated in cache lines, with a subclass inheriting that.
+ */
+
+#define Aligned_ char c; int v __attribute__((aligned(32)));
+#define Aligned__
+_SCOclassdef(Aligned);
+_SCOmetainst(Aligned, scoNone, 0, 0);
+
+#define Padded_ int count;
+#define Padded__
+_SCOclassdef(Padded);
+_SCOmetainst(Padded, scoNone, 0, 0, SCO_CACHELINE | SCO_POOL);
+
+#define SubPadded_ Padded_ int more;
+#define SubPadded__ Padded__
+_SCOclassdef(SubPadded);
+_SCOmetainst(SubPadded, Padded, 0, 0);
+
+static int all_aligned(void *const *objs, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		if ((uintptr_t)objs[i] % ((scoObject*)objs[i])->meta->align)
+			return 0;
+	return 1;
+}
+
+#define MANY 200
+
+static jmp_buf fatal_env;
+
+static void fatal_jump(const char *msg, ...)
+{
+	va_list ap;
+	va_start(ap, msg);
+	vprintf(msg, ap);
+	va_end(ap);
+	putchar('\n');
+	longjmp(fatal_env, 1);
+}
+
+/* checks that creating an instance of NotThing is a fatal error */
+static int final_subclass_fatal(void)
+{
+	void (*default_fatal)(const char *msg, ...) = sco_fatal;
+	sco_fatal = fatal_jump;
+	if (setjmp(fatal_env)) {
+		sco_fatal = default_fatal;
+		return 1;
+	}
+	sco_raw_new(0, sco_metaof(NotThing));
+	sco_fatal = default_fatal;
+	return 0;
+}
+
 int main()
 {
-	scoThing *thing = sco_Thing_new(0);
-	scoExtendedThing *ething = sco_ExtendedThing_new(0);
+	scoThing *thing, *things[10], *many[MANY];
+	Tracked *tracked[10], local_tracked;
+	Proto *protos[10], local_proto, proto_array[10];
+	SubBuffer *buffer, *buffer_copy;
+	void *aligned[10];
+	scoExtendedThing *ething;
+	scoPoolStats stats;
+	int i, ok = 1;
+
+	/* Allocate scoThing instances from a pool, using small slabs.
+	 */
+	if (!sco_pool_enable(sco_metaof(scoThing), 4)) {
+		puts("failed to enable pool for scoThing");
+		ok = 0;
+	}
+	if (!sco_proto_enable(sco_metaof(Proto), (scoCtor)Proto_defaults)) {
+		puts("failed to enable prototype for Proto");
+		ok = 0;
+	}
+
+	thing = sco_Thing_new(0);
+	ething = sco_ExtendedThing_new(0);
 	StaticThing_new(&sthing);
 
 	/* RTTI and virtual function tests.
 	 */
-	if (sco_of_class(thing, scoThing))
+	if (sco_of_class(thing, scoThing) && sco_of_subclass(thing, scoNone))
 		puts("'thing' is a scoThing");
+	else
+		ok = 0;
 	sco_virt(do_foo, thing);
 	sco_virt(do_bar, thing);
 
 	if (sco_of_class(ething, scoExtendedThing))
 		puts("'ething' is a scoExtendedThing");
+	else
+		ok = 0;
 	if (sco_of_subclass(ething, scoThing))
 		puts("'ething' inherits scoThing");
+	else
+		ok = 0;
 	sco_virt(do_foo, ething);
 	sco_virt(do_bar, ething);
 	sco_virt(do_baz, ething, 2, "aaa", "bbb");
 	sco_virt(do_bar, &sthing);
+	sco_fvirt(StaticThing, do_foo, &sthing);
+	sco_fvirt(StaticThing, do_bar, &sthing);
+
+	/* Deriving from a final class is a fatal error.
+	 */
+	if (!final_subclass_fatal()) {
+		puts("no error for subclass of final class");
+		ok = 0;
+	}
+
+	/* Batch calls for mixed arrays, grouping by class; the array is
+	 * reordered to keep objects of each class together.
+	 */
+	things[0] = thing;
+	things[1] = (scoThing*)ething;
+	things[2] = (scoThing*)&sthing;
+	things[3] = (scoThing*)ething;
+	things[4] = thing;
+	sco_virt_batch(do_foo, things, 5);
+	if (things[1] == thing && things[2] == (scoThing*)ething)
+		puts("batch call grouped array by class");
+	else
+		ok = 0;
 
 	/* Recreate fresh scoThing instance reusing the same memory
 	 * allocation.
@@ -85,6 +339,149 @@ int main()
 	sco_set_metaof(thing, scoThing);
 	if (sco_Thing_ctor(thing))
 		puts("'thing' reconstructed");
+	else
+		ok = 0;
+
+	/* Churn pooled instances; the pool should grow to fit 11 at once,
+	 * and then reuse slots.
+	 */
+	for (i = 0; i < 10; ++i)
+		things[i] = sco_Thing_new(0);
+	for (i = 0; i < 10; ++i)
+		sco_delete(things[i]);
+	for (i = 0; i < 10; ++i)
+		things[i] = sco_Thing_new(0);
+	if (things[9]->x == 10)
+		puts("reused pool slot holds a constructed scoThing");
+	else
+		ok = 0;
+
+	/* Without destructors, the array can be freed in bulk.
+	 */
+	if ((sco_metaof(scoThing)->flags & SCO_TRIVIAL) &&
+	    !(sco_metaof(StaticThing)->flags & SCO_TRIVIAL))
+		puts("scoThing is trivially destructible, StaticThing is not");
+	else
+		ok = 0;
+	sco_delete_n(things, 10);
+	if (sco_pool_stats(sco_metaof(scoThing), &stats) &&
+	    stats.slots >= 11 && stats.allocs == 21)
+		printf("scoThing pool: %zu of %zu slots in %zu slabs used, "
+				"%zu cached, peak %zu, %zu allocations\n",
+				stats.used, stats.slots, stats.slabs,
+				stats.cached, stats.peak, stats.allocs);
+	else
+		ok = 0;
+
+	/* Runs longer than the magazines of the thread hold are handed to
+	 * the pool in bulk, leaving only 'thing' in use.
+	 */
+	for (i = 0; i < MANY; ++i)
+		many[i] = sco_Thing_new(0);
+	sco_delete_n(many, MANY);
+	for (i = 0; i < MANY; ++i)
+		if (!(many[i] = sco_Thing_new(0)) || many[i]->x != 10)
+			ok = 0;
+	sco_delete_n(many, MANY);
+	if (sco_pool_stats(sco_metaof(scoThing), &stats) && stats.used == 1)
+		puts("pool refilled by bulk deletion");
+	else
+		ok = 0;
+
+	/* Prototyped instances are copies of the default-constructed one,
+	 * also when reusing pool slots and given memory.
+	 */
+	for (i = 0; i < 10; ++i)
+		protos[i] = Proto_new(0, i);
+	sco_delete_n(protos, 10);
+	for (i = 0; i < 10; ++i)
+		protos[i] = Proto_new(0, i);
+	Proto_new(&local_proto, 10);
+	if (proto_defaults_calls == 1 && protos[9]->id == 9 &&
+	    protos[9]->weights[7] == 49 && local_proto.weights[3] == 9 &&
+	    local_proto.label == protos[0]->label)
+		puts("instances copied from prototype");
+	else
+		ok = 0;
+	sco_delete_n(protos, 10);
+
+	/* Cloning copies bitwise, then calls copy hooks base class first.
+	 */
+	buffer = SubBuffer_new(0, "buffer");
+	buffer_copy = sco_clone(buffer, 0);
+	if (buffer_copy && copy_order == 2 && buffer_copy->copies == 1 &&
+	    buffer_copy->text != buffer->text &&
+	    !strcmp(buffer_copy->text, "buffer"))
+		puts("clone deep-copied by copy hooks in order");
+	else
+		ok = 0;
+	sco_delete(buffer_copy);
+	sco_delete(buffer);
+	buffer = (SubBuffer*)Buffer_new(0, "buffer");
+	if (!sco_clone(buffer, 0))
+		puts("clone failed with copy hook");
+	else
+		ok = 0;
+	sco_delete(buffer);
+	local_proto.id = 11;
+	if (sco_clone_n(&local_proto, proto_array, 10) == 10 &&
+	    proto_array[9].id == 11 && proto_array[9].weights[7] == 49)
+		puts("array filled with clones");
+	else
+		ok = 0;
+	for (i = 0; i < 10; ++i)
+		sco_finalize(&proto_array[i]);
+	sco_finalize(&local_proto);
+
+	/* Instances are aligned as their classes require, however made.
+	 */
+	for (i = 0; i < 9; ++i)
+		aligned[i] = sco_raw_new(0, (i % 3 == 0) ?
+				(void*)sco_metaof(Aligned) : (i % 3 == 1) ?
+				(void*)sco_metaof(Padded) :
+				(void*)sco_metaof(SubPadded));
+	aligned[9] = sco_clone(aligned[1], 0);
+	if (all_aligned(aligned, 10) &&
+	    sco_metaof(Aligned)->align == 32 &&
+	    sco_metaof(SubPadded)->align == SCO_CACHE_LINE &&
+	    sco_pool_stats(sco_metaof(Padded), &stats) &&
+	    stats.slot_size == SCO_CACHE_LINE)
+		puts("instances aligned as required");
+	else
+		ok = 0;
+	sco_delete_n(aligned, 10);
+
+	/* Destroy all tracked instances at once, each class in creation
+	 * order, except those already destroyed and one untracked.
+	 */
+	for (i = 0; i < 10; ++i)
+		tracked[i] = (i < 5) ? Tracked_new(0, i) :
+			(Tracked*)SubTracked_new(0, i);
+	Tracked_new(&local_tracked, 10);
+	if (!strcmp(sco_vvar(kind, tracked[0]), "tracked") &&
+	    !strcmp(sco_vvar(kind, tracked[5]), "subtracked") &&
+	    !sco_vvar(limit, tracked[0]) && !sco_vvar(limit, tracked[5]))
+		printf("virtual variables: %s %d, %s %d\n",
+				sco_vvar(kind, tracked[0]),
+				sco_vvar(limit, tracked[0]),
+				sco_vvar(kind, tracked[5]),
+				sco_vvar(limit, tracked[5]));
+	else
+		ok = 0;
+	if (tracked_checked == 1 && subtracked_checked == 1)
+		puts("RTTI checks made by vtinit of the classes checked");
+	else
+		ok = 0;
+	sco_delete(tracked[2]);
+	sco_finalize(&local_tracked);
+	sco_untrack(tracked[9]);
+	last_id = -1;
+	sco_clean(sco_metaof(Tracked), sco_delete);
+	if (tracked_order && last_id == 8 && !local_tracked.meta)
+		puts("tracked instances cleaned in creation order");
+	else
+		ok = 0;
+	sco_delete(tracked[9]);
 
 	/* Not necessary as OS cleans up memory at program exit, but included
 	 * for testing.
@@ -93,5 +490,6 @@ int main()
 	sco_delete(ething);
 	sco_finalize(&sthing); /* this one will print something... */
 
-	return 0;
+	puts(ok ? "object test ok" : "object test FAILED");
+	return !ok;
 }
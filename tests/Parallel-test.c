@@ -0,0 +1,185 @@
+/* Simple test program for the SCOOP Parallel module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Parallel.h>
+#include <stdio.h>
+#include <string.h>
+
+#define COUNT 10000
+#define INNER 16
+
+/*
+ * Items counting their visits, with a subclass counting differently,
+ * mixed in one array. Each is visited by one thread at a time, so the
+ * counts are plain; the total is atomic.
+ */
+
+#define Item_ int visits;
+#define Item__ \
+	void (*visit)(void *o, void *arg); \
+	void (*tally)(void *o, void *arg); \
+	void (*nest)(void *o, void *arg);
+_SCOclassdef(Item);
+
+#define Other_ Item_
+#define Other__ Item__
+_SCOclassdef(Other);
+
+static Item *inner[INNER];
+
+static void Item_visit(void *o, void *arg)
+{
+	++((Item*)o)->visits;
+	__atomic_add_fetch((long*)arg, 1, __ATOMIC_RELAXED);
+}
+
+static void Other_visit(void *o, void *arg)
+{
+	((Item*)o)->visits += 2;
+	__atomic_add_fetch((long*)arg, 2, __ATOMIC_RELAXED);
+}
+
+/* counts visits from several threads at once */
+static void Item_tally(void *o, void *arg)
+{
+	(void) arg;
+	__atomic_add_fetch(&((Item*)o)->visits, 1, __ATOMIC_RELAXED);
+}
+
+/* calls back into the pool, given as the argument */
+static void Item_nest(void *o, void *arg)
+{
+	++((Item*)o)->visits;
+	sco_parallel_virt((scoParallel*)arg, tally, inner, INNER, 1, 0, 0);
+}
+
+static void Item_vtinit(Item_Meta *o)
+{
+	o->virt.visit = Item_visit;
+	o->virt.tally = Item_tally;
+	o->virt.nest = Item_nest;
+}
+_SCOmetainst(Item, scoNone, 0, Item_vtinit);
+
+static void Other_vtinit(Other_Meta *o)
+{
+	o->virt.visit = Other_visit;
+}
+_SCOmetainst(Other, Item, 0, Other_vtinit);
+
+static Item *items[COUNT], *mixed[COUNT];
+
+/* checks that each item was visited once, and clears the counts */
+static int visited_once(long total)
+{
+	long expected = 0;
+	int ok = 1, i;
+	for (i = 0; i < COUNT; ++i) {
+		int weight = (items[i]->meta == (void*) sco_metaof(Other)) ?
+			2 : 1;
+		if (items[i]->visits != weight)
+			ok = 0;
+		items[i]->visits = 0;
+		expected += weight;
+	}
+	return ok && total == expected;
+}
+
+static int grouped(void)
+{
+	int i, changes = 0;
+	for (i = 1; i < COUNT; ++i)
+		if (items[i]->meta != items[i - 1]->meta)
+			++changes;
+	return changes == 1;
+}
+
+static int test_pool(scoParallel *pool)
+{
+	static const size_t grains[] = {0, 1, 7, 500, COUNT};
+	int ok = 1, i;
+	size_t g;
+	for (g = 0; g < sizeof(grains) / sizeof(*grains); ++g) {
+		long total = 0;
+		sco_parallel_virt(pool, visit, items, COUNT, grains[g], 0,
+				&total);
+		if (!visited_once(total))
+			ok = 0;
+		total = 0;
+		sco_parallel_virt(pool, visit, items, COUNT, grains[g],
+				SCO_PARALLEL_GROUP, &total);
+		if (!visited_once(total))
+			ok = 0;
+	}
+	/* the last, done in one chunk, grouped the whole array */
+	if (!grouped())
+		ok = 0;
+	memcpy(items, mixed, sizeof(items));
+
+	/* Calls from the methods called are made by their thread alone.
+	 */
+	sco_parallel_virt(pool, nest, items, COUNT, 16, 0, pool);
+	for (i = 0; i < COUNT; ++i) {
+		if (items[i]->visits != 1)
+			ok = 0;
+		items[i]->visits = 0;
+	}
+	for (i = 0; i < INNER; ++i) {
+		if (inner[i]->visits != COUNT)
+			ok = 0;
+		inner[i]->visits = 0;
+	}
+	return ok;
+}
+
+int main()
+{
+	static const unsigned int thread_counts[] = {1, 2, 4, 0};
+	int ok = 1, i;
+	size_t t;
+	for (i = 0; i < COUNT; ++i)
+		mixed[i] = sco_raw_new(0, (i % 3) ? (void*) sco_metaof(Item) :
+				(void*) sco_metaof(Other));
+	memcpy(items, mixed, sizeof(items));
+	for (i = 0; i < INNER; ++i)
+		inner[i] = sco_raw_new(0, sco_metaof(Item));
+
+	/* Without a pool, the caller makes the calls.
+	 */
+	if (!test_pool(0))
+		ok = 0;
+	for (t = 0; t < sizeof(thread_counts) / sizeof(*thread_counts); ++t) {
+		scoParallel *pool = sco_parallel_create(thread_counts[t]);
+		if (!pool || !test_pool(pool))
+			ok = 0;
+		if (pool)
+			sco_parallel_destroy(pool);
+	}
+
+	for (i = 0; i < COUNT; ++i)
+		sco_delete(items[i]);
+	for (i = 0; i < INNER; ++i)
+		sco_delete(inner[i]);
+	puts(ok ? "parallel test ok" : "parallel test FAILED");
+	return !ok;
+}
@@ -0,0 +1,197 @@
+/* Simple test program for the SCOOP Ref module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scoop/Ref.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#define THREADS 4
+#define ROUNDS 100000
+#define RACES 20000
+
+/*
+ * A reference-counted class, counting the instances destroyed.
+ */
+
+#define Item_ scoRef_ int value;
+#define Item__ scoRef__
+_SCOclassdef(Item);
+
+static int deleted;
+
+static void Item_dtor(Item *o)
+{
+	(void) o;
+	__atomic_add_fetch(&deleted, 1, __ATOMIC_RELAXED);
+}
+_SCOmetainst(Item, scoRef, Item_dtor, 0);
+
+_SCOctordef(Item, Item,, (Item *o, int value), (o, value))
+{
+	sco_Ref_ctor((scoRef*)o);
+	o->value = value;
+	return 1;
+}
+
+/* takes and drops references, then drops the one given to it */
+static void *use_item(void *arg)
+{
+	int i;
+	for (i = 0; i < ROUNDS; ++i)
+		sco_release(sco_retain(arg));
+	sco_release(arg);
+	return 0;
+}
+
+static scoRef *race_handoff, *race_back;
+
+static scoRef *race_wait(scoRef **slot)
+{
+	scoRef *o;
+	while (!(o = __atomic_exchange_n(slot, 0, __ATOMIC_ACQUIRE)))
+		sched_yield();
+	return o;
+}
+
+/* drops each reference handed to it as soon as it is handed over; in
+ * odd rounds, after taking one of its own and handing that one back */
+static void *race_items(void *arg)
+{
+	int i;
+	(void) arg;
+	for (i = 0; i < RACES; ++i) {
+		scoRef *o = race_wait(&race_handoff);
+		if (i & 1)
+			__atomic_store_n(&race_back, sco_retain(o),
+					__ATOMIC_RELEASE);
+		sco_release(o);
+	}
+	return 0;
+}
+
+static void *make_item(void *arg)
+{
+	(void) arg;
+	return Item_new(0, 1);
+}
+
+static int deleted_count(void)
+{
+	return __atomic_load_n(&deleted, __ATOMIC_RELAXED);
+}
+
+int main()
+{
+	pthread_t thread[THREADS];
+	Item *item, *copy;
+	void *made;
+	int ok = 1, i;
+
+	/* The owner's references alone.
+	 */
+	item = Item_new(0, 1);
+	for (i = 0; i < 3; ++i)
+		sco_retain(item);
+	for (i = 0; i < 3; ++i)
+		sco_release(item);
+	if (deleted_count() != 0)
+		ok = 0;
+	sco_release(item);
+	if (deleted_count() != 1)
+		ok = 0;
+
+	/* Other threads dropping references taken by the owner hand the
+	 * object back to it, to be merged when the owner next releases.
+	 */
+	item = Item_new(0, 2);
+	for (i = 0; i < THREADS; ++i)
+		pthread_create(&thread[i], 0, use_item, sco_retain(item));
+	for (i = 0; i < THREADS; ++i)
+		pthread_join(thread[i], 0);
+	if (deleted_count() != 1)
+		ok = 0;
+	sco_release(item);
+	if (deleted_count() != 2)
+		ok = 0;
+
+	/* ...or on collecting.
+	 */
+	item = Item_new(0, 3);
+	pthread_create(&thread[0], 0, use_item, sco_retain(item));
+	pthread_join(thread[0], 0);
+	sco_ref_collect();
+	if (deleted_count() != 2)
+		ok = 0;
+	sco_release(item);
+	if (deleted_count() != 3)
+		ok = 0;
+
+	/* The owner and another thread dropping the last two references
+	 * at the same time, the other thread's counted by the owner or not.
+	 */
+	pthread_create(&thread[0], 0, race_items, 0);
+	for (i = 0; i < RACES; ++i) {
+		item = Item_new(0, 4);
+		__atomic_store_n(&race_handoff, sco_retain(item),
+				__ATOMIC_RELEASE);
+		if (i & 1)
+			sco_release(race_wait(&race_back));
+		sco_release(item);
+		while (__atomic_load_n(&race_handoff, __ATOMIC_ACQUIRE))
+			sched_yield();
+	}
+	pthread_join(thread[0], 0);
+	sco_ref_collect();
+	if (deleted_count() != 3 + RACES)
+		ok = 0;
+
+	/* An object outliving the thread which created it.
+	 */
+	pthread_create(&thread[0], 0, make_item, 0);
+	pthread_join(thread[0], &made);
+	sco_retain(made);
+	sco_release(made);
+	if (deleted_count() != 3 + RACES)
+		ok = 0;
+	sco_release(made);
+	if (deleted_count() != 4 + RACES)
+		ok = 0;
+
+	/* A copy starts with a reference of its own.
+	 */
+	item = Item_new(0, 5);
+	sco_retain(item);
+	copy = sco_clone(item, 0);
+	sco_release(copy);
+	sco_release(item);
+	if (!copy || deleted_count() != 5 + RACES)
+		ok = 0;
+	sco_release(item);
+	if (deleted_count() != 6 + RACES)
+		ok = 0;
+
+	printf("%d objects deleted\n", deleted_count());
+	puts(ok ? "ref test ok" : "ref test FAILED");
+	return !ok;
+}
@@ -0,0 +1,112 @@
+/* Simple test program for the SCOOP Registry module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Registry.h>
+#include <stdio.h>
+#include <string.h>
+
+#define EXTRA 200
+
+/*
+ * A base class, a subclass of it, and a class never initialized.
+ */
+
+#define Base_ int value;
+#define Base__
+_SCOclassdef(Base);
+_SCOmetainst(Base, scoNone, 0, 0);
+
+#define Sub_ Base_
+#define Sub__ Base__
+_SCOclassdef(Sub);
+_SCOmetainst(Sub, Base, 0, 0);
+
+#define Unused_ Base_
+#define Unused__ Base__
+_SCOclassdef(Unused);
+_SCOmetainst(Unused, Base, 0, 0);
+
+/* copies of the Unused meta type under other names, made at run time
+ * like the classes of a plugin, enough to make the registry grow */
+static Unused_Meta extra[EXTRA];
+static char extra_names[EXTRA][16];
+
+static void count_class(void *meta, void *arg)
+{
+	unsigned int *count = arg;
+	if (((scoObject_Meta*)meta)->id == *count + 1)
+		++*count;
+}
+
+int main()
+{
+	unsigned int count, walked = 0, i;
+	Sub *sub;
+	int ok = 1;
+
+	/* Creating an instance registers the class and its superclass,
+	 * superclass first.
+	 */
+	if (sco_class_find("Sub") || sco_class_find("Base") ||
+	    sco_class_count() != 0)
+		ok = 0;
+	sub = sco_raw_new(0, sco_metaof(Sub));
+	if (sco_class_find("Sub") != sco_metaof(Sub) ||
+	    sco_class_find("Base") != sco_metaof(Base) ||
+	    sco_class_get(1) != sco_metaof(Base) ||
+	    sco_class_get(2) != sco_metaof(Sub) ||
+	    sco_metaof(Sub)->id != 2 || sco_class_count() != 2)
+		ok = 0;
+	sco_delete(sub);
+
+	/* Initializing registers without creating an instance.
+	 */
+	for (i = 0; i < EXTRA; ++i) {
+		extra[i] = *sco_metaof(Unused);
+		sprintf(extra_names[i], "Extra%u", i);
+		extra[i].name = extra_names[i];
+		sco_meta_init(&extra[i]);
+	}
+	if (sco_class_find("Unused"))
+		ok = 0;
+	sco_meta_init(sco_metaof(Unused));
+	count = sco_class_count();
+	if (count != 3 + EXTRA ||
+	    sco_class_find("Unused") != sco_metaof(Unused) ||
+	    sco_class_get(count) != sco_metaof(Unused) ||
+	    sco_class_get(0) || sco_class_get(count + 1) ||
+	    sco_class_find("Extra") || sco_class_find(""))
+		ok = 0;
+	for (i = 0; i < EXTRA; ++i)
+		if (sco_class_find(extra_names[i]) != &extra[i] ||
+		    sco_class_get(3 + i) != &extra[i])
+			ok = 0;
+	sco_class_walk(count_class, &walked);
+	if (walked != count)
+		ok = 0;
+
+	printf("%u classes registered\n", count);
+	puts(ok ? "registry test ok" : "registry test FAILED");
+	return !ok;
+}
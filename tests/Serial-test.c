@@ -0,0 +1,290 @@
+/* Simple test program for the SCOOP Serial module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Registry.h>
+#include <scoop/Serial.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODES 1000
+
+/*
+ * A node class with object pointers, a subclass adding data, and a
+ * class without a field table, written as plain data.
+ */
+
+#define Node_ int value; void *next; void *other;
+#define Node__
+_SCOclassdef(Node);
+
+static const scoField Node_fields[] = {
+	SCO_FIELD(Node, value),
+	SCO_FIELD_OBJ(Node, next),
+	SCO_FIELD_OBJ(Node, other),
+	SCO_FIELD_END
+};
+
+static void Node_vtinit(Node_Meta *o)
+{
+	o->fields = Node_fields;
+}
+
+_SCOmetainst(Node, scoNone, 0, Node_vtinit);
+
+#define Leaf_ Node_ double weight; char tag[8]; int scratch;
+#define Leaf__ Node__
+_SCOclassdef(Leaf);
+
+static const scoField Leaf_fields[] = {
+	SCO_FIELD(Leaf, weight),
+	SCO_FIELD(Leaf, tag),
+	SCO_FIELD_END
+};
+
+static void Leaf_vtinit(Leaf_Meta *o)
+{
+	o->fields = Leaf_fields;
+}
+
+_SCOmetainst(Leaf, Node, 0, Leaf_vtinit);
+
+#define Point_ float x, y, z;
+#define Point__
+_SCOclassdef(Point);
+_SCOmetainst(Point, scoNone, 0, 0);
+
+/* a class only created by reading, so not initialized before */
+#define Fresh_ int value; void *self;
+#define Fresh__
+_SCOclassdef(Fresh);
+
+static const scoField Fresh_fields[] = {
+	SCO_FIELD(Fresh, value),
+	SCO_FIELD_OBJ(Fresh, self),
+	SCO_FIELD_END
+};
+
+static void Fresh_vtinit(Fresh_Meta *o)
+{
+	o->fields = Fresh_fields;
+}
+
+_SCOmetainst(Fresh, scoNone, 0, Fresh_vtinit);
+
+static void *const metas[] = {
+	sco_metaof(Node), sco_metaof(Leaf), sco_metaof(Point)
+};
+
+/* output to a growing buffer */
+typedef struct Buffer {
+	unsigned char *data;
+	size_t size, alloc, pos;
+} Buffer;
+
+static int buffer_write(void *arg, const void *data, size_t size)
+{
+	Buffer *o = arg;
+	if (o->size + size > o->alloc) {
+		size_t alloc = (o->size + size) * 2;
+		unsigned char *p = realloc(o->data, alloc);
+		if (!p)
+			return 0;
+		o->data = p;
+		o->alloc = alloc;
+	}
+	memcpy(o->data + o->size, data, size);
+	o->size += size;
+	return 1;
+}
+
+/* input in pieces of at most 7 bytes */
+static size_t buffer_read(void *arg, void *data, size_t size)
+{
+	Buffer *o = arg;
+	if (size > 7) size = 7;
+	if (size > o->size - o->pos) size = o->size - o->pos;
+	memcpy(data, o->data + o->pos, size);
+	o->pos += size;
+	return size;
+}
+
+/* a list of nodes, every third a leaf, each pointing to a point,
+ * the list head, or nothing, and the last to the first */
+static Node *make_graph(void)
+{
+	Node *nodes[NODES];
+	int i;
+	for (i = 0; i < NODES; ++i) {
+		nodes[i] = sco_raw_new(0, (i % 3) ? (void*)sco_metaof(Node) :
+				(void*)sco_metaof(Leaf));
+		nodes[i]->value = i;
+		if (!(i % 3)) {
+			Leaf *leaf = (Leaf*)nodes[i];
+			leaf->weight = i * 0.5;
+			sprintf(leaf->tag, "n%d", i);
+			leaf->scratch = -1;
+		}
+	}
+	for (i = 0; i < NODES; ++i) {
+		nodes[i]->next = nodes[(i + 1) % NODES];
+		if (i % 5 == 1) {
+			Point *p = sco_raw_new(0, sco_metaof(Point));
+			p->x = i;
+			p->y = -i;
+			p->z = 0.25f;
+			nodes[i]->other = p;
+		} else if (i % 5 == 2) {
+			nodes[i]->other = nodes[0];
+		}
+	}
+	return nodes[0];
+}
+
+static void delete_graph(Node *head)
+{
+	Node *o = head;
+	do {
+		if (o->other && sco_of_class((scoObject*)o->other, Point))
+			sco_delete(o->other);
+		o = o->next;
+	} while (o != head);
+	do {
+		Node *next = o->next;
+		sco_delete(o);
+		o = next;
+	} while (o != head);
+}
+
+static int same_graph(const Node *a, const Node *b)
+{
+	const Node *head = b;
+	int i;
+	for (i = 0; i < NODES; ++i, a = a->next, b = b->next) {
+		if (a->meta != b->meta || a->value != b->value)
+			return 0;
+		if (sco_of_class(a, Leaf)) {
+			const Leaf *la = (const Leaf*)a, *lb = (const Leaf*)b;
+			if (la->weight != lb->weight ||
+			    strcmp(la->tag, lb->tag) || lb->scratch != 0)
+				return 0;
+		}
+		if (i % 5 == 1) {
+			const Point *pa = a->other, *pb = b->other;
+			if (!pb || pa == pb || !sco_of_class(pb, Point) ||
+			    pa->x != pb->x || pa->y != pb->y || pa->z != pb->z)
+				return 0;
+		} else if (i % 5 == 2) {
+			if (b->other != head)
+				return 0;
+		} else if (b->other) {
+			return 0;
+		}
+	}
+	return b == head;
+}
+
+/* reads a Fresh object pointing to itself, from input made by hand,
+ * finding the class by name */
+static int read_fresh(void)
+{
+	static const unsigned char head[] = {
+		'S', 'C', 'O', 1, /* magic */
+		1, 1, /* root count, root number */
+		0, 5, 'F', 'r', 'e', 's', 'h', sizeof(Fresh) /* new class */
+	};
+	unsigned char self = 1;
+	int value = 42;
+	Buffer in = {0};
+	void *root;
+	int ok;
+	if (!buffer_write(&in, head, sizeof(head)) ||
+	    !buffer_write(&in, &value, sizeof(value)) ||
+	    !buffer_write(&in, &self, 1))
+		return 0;
+	ok = sco_deserialize_mem(&root, 1, in.data, in.size, 0, 0) &&
+		sco_of_class((scoObject*)root, Fresh) &&
+		((Fresh*)root)->value == 42 && ((Fresh*)root)->self == root;
+	if (ok)
+		sco_delete(root);
+	free(in.data);
+	return ok;
+}
+
+int main()
+{
+	Buffer buf = {0};
+	void *roots[3], *copy[3];
+	Node *head = make_graph();
+	int ok = 1;
+
+	/* Find a class in the program by name before it is initialized.
+	 */
+	if (sco_class_find("Fresh") || !read_fresh() ||
+	    sco_class_find("Fresh") != sco_metaof(Fresh))
+		ok = 0;
+
+	/* Write the list, with the head twice and a NULL root.
+	 */
+	roots[0] = head;
+	roots[1] = 0;
+	roots[2] = head;
+	if (!sco_serialize(roots, 3, buffer_write, &buf))
+		ok = 0;
+
+	/* Read it back from memory, and from a stream.
+	 */
+	if (!sco_deserialize_mem(copy, 3, buf.data, buf.size, metas, 3) ||
+	    copy[1] || copy[0] != copy[2] || !same_graph(head, copy[0]))
+		ok = 0;
+	else
+		delete_graph(copy[0]);
+	if (!sco_deserialize(copy, 3, buffer_read, &buf, metas, 3) ||
+	    copy[1] || copy[0] != copy[2] || !same_graph(head, copy[0]))
+		ok = 0;
+	else
+		delete_graph(copy[0]);
+
+	/* Find the classes in the registry.
+	 */
+	if (!sco_deserialize_mem(copy, 3, buf.data, buf.size, 0, 0) ||
+	    !same_graph(head, copy[0]))
+		ok = 0;
+	else
+		delete_graph(copy[0]);
+
+	/* Truncated input, a missing class, and a wrong root count fail.
+	 */
+	if (sco_deserialize_mem(copy, 3, buf.data, buf.size / 2, metas, 3) ||
+	    copy[0] || sco_deserialize_mem(copy, 3, buf.data, buf.size,
+		    metas, 2) ||
+	    sco_deserialize_mem(copy, 2, buf.data, buf.size, metas, 3))
+		ok = 0;
+
+	printf("%d nodes in %zu bytes\n", NODES, buf.size);
+	delete_graph(head);
+	free(buf.data);
+	puts(ok ? "serial test ok" : "serial test FAILED");
+	return !ok;
+}
@@ -0,0 +1,145 @@
+/* Simple test program for the SCOOP SoA (structure of arrays) module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/SoA.h>
+#include <stdio.h>
+
+/*
+ * A plain struct type, and a class extending it.
+ */
+
+#define Point_SOA(X) X(float, x) X(float, y)
+#define Point_ SCO_SOA_MEMBERS(Point_SOA)
+SCOstructdef(Point);
+SCOsoadef(Point);
+
+#define Particle_SOA(X) Point_SOA(X) X(char, kind) X(double, mass)
+#define Particle_ SCO_SOA_MEMBERS(Particle_SOA)
+#define Particle__ double (*energy)(void *o);
+_SCOclassdef(Particle);
+SCOsoadef(Particle);
+
+static double Particle_energy(void *_o)
+{
+	Particle *o = _o;
+	return o->mass * (o->x * o->x + o->y * o->y) / 2;
+}
+
+static void Particle_vtinit(Particle_Meta *o)
+{
+	o->virt.energy = Particle_energy;
+}
+_SCOmetainst(Particle, scoNone, 0, Particle_vtinit);
+
+/*
+ * A tracked class, with the tracking link before the listed members,
+ * an over-aligned member, and an array member.
+ */
+
+typedef float Vec3[3];
+#define Body_SOA(X) X(char, kind) X(Vec3, pos) X(double, mass)
+/* as Body_SOA, but with pos aligned beyond what its type requires */
+#define Body_SOA_ALIGNED(X) X(char, kind) \
+	X(Vec3 __attribute__((aligned(32))), pos) X(double, mass)
+#define Body_ scoTracked_ SCO_SOA_MEMBERS(Body_SOA_ALIGNED)
+#define Body__
+_SCOclassdef(Body);
+SCOsoadef(Body);
+_SCOmetainst(Body, scoNone, 0, 0, SCO_TRACK);
+
+#define COUNT 1000
+
+int main()
+{
+	Point_SoA points;
+	Particle_SoA particles;
+	Body_SoA bodies;
+	Particle p = {0};
+	Body b = {0};
+	size_t i;
+	int ok = 1;
+
+	/* Columns for a plain struct.
+	 */
+	sco_soa_init(Point, &points, 0);
+	for (i = 0; i < COUNT; ++i) {
+		Point pt = {(float)i, -(float)i};
+		if (sco_soa_push(&points, &pt) != i)
+			ok = 0;
+	}
+	for (i = 0; i < sco_soa_count(&points); ++i)
+		sco_soa_column(&points, x)[i] += sco_soa_column(&points, y)[i];
+	for (i = 0; i < sco_soa_count(&points); ++i)
+		if (points.x[i] != 0.f) ok = 0;
+	if ((size_t)points.x % SCO_SOA_ALIGN || (size_t)points.y % SCO_SOA_ALIGN)
+		ok = 0;
+	sco_soa_fini(&points);
+
+	/* Columns for a class, sharing its meta type.
+	 */
+	sco_soa_init(Particle, &particles, sco_metaof(Particle));
+	for (i = 0; i < COUNT; ++i) {
+		p.x = (float)i;
+		p.y = 0.f;
+		p.kind = (char)(i % 3);
+		p.mass = 2.0;
+		sco_soa_push(&particles, &p);
+	}
+	sco_soa_erase(&particles, 1); /* the last one takes its place */
+	if (sco_soa_count(&particles) != COUNT - 1 ||
+	    particles.x[1] != (float)(COUNT - 1) ||
+	    particles.kind[1] != (COUNT - 1) % 3)
+		ok = 0;
+	sco_soa_get(&particles, 2, &p);
+	if (!sco_of_class(&p, Particle) || sco_virt(energy, &p) != 4.0 ||
+	    p.kind != 2)
+		ok = 0;
+	p.mass = 4.0;
+	sco_soa_set(&particles, 2, &p);
+	if (particles.mass[2] != 4.0 || particles.x[2] != 2.f)
+		ok = 0;
+	sco_soa_fini(&particles);
+
+	/* Columns for members placed other than in the plain way.
+	 */
+	sco_soa_init(Body, &bodies, sco_metaof(Body));
+	for (i = 0; i < 10; ++i) {
+		b.kind = (char)i;
+		b.pos[0] = (float)i;
+		b.pos[2] = -(float)i;
+		b.mass = i * 0.5;
+		sco_soa_push(&bodies, &b);
+	}
+	if (bodies.pos[3][0] != 3.f || bodies.pos[3][2] != -3.f ||
+	    bodies.mass[3] != 1.5 || bodies.kind[3] != 3)
+		ok = 0;
+	sco_soa_get(&bodies, 7, &b);
+	if (!sco_of_class(&b, Body) || b.kind != 7 || b.pos[0] != 7.f ||
+	    b.pos[2] != -7.f || b.mass != 3.5)
+		ok = 0;
+	sco_soa_fini(&bodies);
+
+	puts(ok ? "SoA test ok" : "SoA test FAILED");
+	return !ok;
+}
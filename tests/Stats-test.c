@@ -0,0 +1,162 @@
+/* Simple test program for the SCOOP Stats module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <scoop/Stats.h>
+#include <scoop/Arena.h>
+#include <scoop/SoA.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#define THREADS 4
+#define ROUNDS 1000
+
+/*
+ * A class with a destructor, and a constructor which fails for
+ * negative values.
+ */
+
+#define Item_ int value;
+#define Item__
+_SCOclassdef(Item);
+
+static void Item_dtor(Item *o)
+{
+	o->value = 0;
+}
+
+_SCOmetainst(Item, scoNone, Item_dtor, 0);
+_SCOctordef(Item, Item,, (Item *o, int value), (o, value))
+{
+	o->value = value;
+	return value >= 0;
+}
+
+/*
+ * A class without a destructor, kept in a structure of arrays.
+ */
+
+#define Point_SOA(X) X(int, x) X(int, y)
+#define Point_ SCO_SOA_MEMBERS(Point_SOA)
+#define Point__
+_SCOclassdef(Point);
+SCOsoadef(Point);
+_SCOmetainst(Point, scoNone, 0, 0);
+
+static void *worker(void *arg)
+{
+	int i;
+	(void)arg;
+	for (i = 0; i < ROUNDS; ++i)
+		sco_delete(Item_new(0, i));
+	return 0;
+}
+
+static void find_item(const scoClassStats *stats, void *found)
+{
+	if (stats->meta == sco_metaof(Item))
+		*(int*)found = 1;
+}
+
+int main()
+{
+	pthread_t threads[THREADS];
+	scoClassStats stats;
+	scoArena *arena;
+	Point_SoA points;
+	Point point = {0};
+	Item *items[10], local;
+	int i, found = 0, ok = 1;
+
+	/* Create 10, delete 4, construct and finalize one in place,
+	 * and fail to construct 2.
+	 */
+	for (i = 0; i < 10; ++i)
+		items[i] = Item_new(0, i);
+	for (i = 0; i < 4; ++i)
+		sco_delete(items[i]);
+	sco_finalize(Item_new(&local, 1));
+	if (Item_new(0, -1) || Item_new(&local, -1))
+		ok = 0;
+	if (!sco_stats_get(sco_metaof(Item), &stats)) {
+		puts("stats test FAILED, nothing counted");
+		return 1;
+	}
+	if (stats.live != 6 || stats.peak != 10 || stats.allocs != 13 ||
+	    stats.failures != 2 || stats.bytes != 6 * sizeof(Item))
+		ok = 0;
+
+	/* Churn from several threads, which leaves the live count.
+	 */
+	for (i = 0; i < THREADS; ++i)
+		pthread_create(&threads[i], 0, worker, 0);
+	for (i = 0; i < THREADS; ++i)
+		pthread_join(threads[i], 0);
+	sco_stats_get(sco_metaof(Item), &stats);
+	if (stats.live != 6 || stats.allocs != 13 + THREADS * ROUNDS)
+		ok = 0;
+
+	/* Instances in an arena are counted once, and until destroyed with
+	 * the arena.
+	 */
+	arena = sco_arena_create(0);
+	for (i = 0; i < 5; ++i)
+		Item_new(sco_arena_raw_new(arena, sco_metaof(Item)), i);
+	sco_stats_get(sco_metaof(Item), &stats);
+	if (stats.live != 11 || stats.allocs != 18 + THREADS * ROUNDS)
+		ok = 0;
+	sco_arena_destroy(arena);
+	sco_stats_get(sco_metaof(Item), &stats);
+	if (stats.live != 6)
+		ok = 0;
+
+	/* Nor are instances without destructors left live by the arena,
+	 * and copies out of a structure of arrays are not counted at all.
+	 */
+	arena = sco_arena_create(0);
+	for (i = 0; i < 5; ++i)
+		sco_raw_new(sco_arena_raw_new(arena, sco_metaof(Point)),
+				sco_metaof(Point));
+	sco_stats_get(sco_metaof(Point), &stats);
+	if (stats.live != 5)
+		ok = 0;
+	sco_arena_destroy(arena);
+	sco_soa_init(Point, &points, sco_metaof(Point));
+	point.x = 1;
+	sco_soa_push(&points, &point);
+	for (i = 0; i < 5; ++i)
+		sco_soa_get(&points, 0, &point);
+	sco_soa_fini(&points);
+	sco_stats_get(sco_metaof(Point), &stats);
+	if (stats.live != 0 || stats.allocs != 5 || point.x != 1)
+		ok = 0;
+	sco_stats_walk(find_item, &found);
+	if (!found)
+		ok = 0;
+	for (i = 4; i < 10; ++i)
+		sco_delete(items[i]);
+	sco_stats_dump(stdout);
+
+	puts(ok ? "stats test ok" : "stats test FAILED");
+	return !ok;
+}
@@ -0,0 +1,122 @@
+/* Simple test program for the SCOOP Trace module
+ *
+ * Copyright (c) 2010, 2011, 2013, 2022 Joel K. Pettersson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCO_TRACE
+# define SCO_TRACE
+#endif
+#include <scoop/Trace.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CALLS 1000
+
+/*
+ * A base class with a method, a static method and a void method, and
+ * a subclass overriding the first.
+ */
+
+#define Shape_ int size;
+#define Shape__ \
+	int (*area)(void *o); \
+	int (*sides)(void); \
+	void (*grow)(void *o, int by);
+_SCOclassdef(Shape);
+
+static int Shape_area(void *o) { return ((Shape*)o)->size; }
+static int Shape_sides(void) { return 0; }
+static void Shape_grow(void *o, int by) { ((Shape*)o)->size += by; }
+
+static void Shape_vtinit(Shape_Meta *o)
+{
+	o->virt.area = Shape_area;
+	o->virt.sides = Shape_sides;
+	o->virt.grow = Shape_grow;
+}
+
+_SCOmetainst(Shape, scoNone, 0, Shape_vtinit);
+
+#define Square_ Shape_
+#define Square__ Shape__
+_SCOclassdef(Square);
+
+static int Square_area(void *o)
+{
+	return ((Square*)o)->size * ((Square*)o)->size;
+}
+
+static void Square_vtinit(Square_Meta *o)
+{
+	o->virt.area = Square_area;
+}
+
+_SCOmetainst(Square, Shape, 0, Square_vtinit);
+
+static int check(const scoTraceStats *stats, const void *meta,
+		const char *method, unsigned long long calls)
+{
+	return stats->meta != meta || strcmp(stats->method, method) ||
+		stats->calls == calls;
+}
+
+static void check_stats(const scoTraceStats *stats, void *arg)
+{
+	int *ok = arg;
+	if (!check(stats, sco_metaof(Shape), "area", CALLS) ||
+	    !check(stats, sco_metaof(Shape), "grow", CALLS) ||
+	    !check(stats, sco_metaof(Square), "area", 2 * CALLS) ||
+	    !check(stats, sco_metaof(Square), "sides", CALLS) ||
+	    stats->samples > stats->calls || stats->samples == 0 ||
+	    stats->slot == 0)
+		*ok = 0;
+}
+
+static void count_stats(const scoTraceStats *stats, void *arg)
+{
+	(void)stats;
+	++*(int*)arg;
+}
+
+int main()
+{
+	Shape *shape = sco_raw_new(0, sco_metaof(Shape));
+	Square *square = sco_raw_new(0, sco_metaof(Square));
+	long sum = 0;
+	int i, ok = 1, count = 0;
+	for (i = 0; i < CALLS; ++i) {
+		sco_virt(grow, shape, 1);
+		sum += sco_virt(area, shape);
+		sum += sco_virt(area, square) + sco_virt(area, square);
+		sum += sco_svirt(sides, square);
+	}
+	if (sum != (long) CALLS * (CALLS + 1) / 2)
+		ok = 0;
+	if (!sco_trace_walk(check_stats, &ok) ||
+	    !sco_trace_walk(count_stats, &count) || count != 4 ||
+	    sco_trace_lost())
+		ok = 0;
+	sco_trace_dump(stdout);
+	sco_delete(shape);
+	sco_delete(square);
+	puts(ok ? "trace test ok" : "trace test FAILED");
+	return !ok;
+}